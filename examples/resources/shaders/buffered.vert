@@ -34,7 +34,7 @@ void main() {
   vec2 fix = vec2(sign(mod_coord.x - 0.51) * -0.005,
                   sign(mod_coord.y - 0.51) * -0.005);
 
-  vec2 tex_size = vec2(raw_coord.w - raw_coord.y, raw_coord.z - raw_coord.x);
+  vec2 tex_size = vec2(raw_coord.z - raw_coord.x, raw_coord.w - raw_coord.y);
 
   vec2 offset = raw_coord.xy;
 
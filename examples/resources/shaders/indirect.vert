@@ -0,0 +1,43 @@
+#version 330
+
+layout(location = 0) in vec3 in_pos;
+layout(location = 1) in vec2 in_texc;
+
+// per instance data (sourced from the batch arrays)
+layout(location = 2) in mat4 in_mat;
+layout(location = 6) in vec4 in_coords;
+layout(location = 7) in vec4 in_color;
+layout(location = 8) in int  in_flip_x;
+layout(location = 9) in int  in_flip_y;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+out vec2 pass_texcoord;
+out vec4 pass_color;
+
+void main() {
+  vec2 mod_coord = in_texc;
+  vec4 raw_coord = in_coords;
+
+  if (in_flip_x == 1) {
+    mod_coord.x = 1.0 - mod_coord.x;
+  }
+
+  if (in_flip_y == 1) {
+    mod_coord.y = 1.0 - mod_coord.y;
+  }
+
+  vec2 tex_size = vec2(raw_coord.z - raw_coord.x, raw_coord.w - raw_coord.y);
+
+  vec2 offset = raw_coord.xy;
+
+  // sprite ordering based on how far down on the screen it is
+  vec4 mod_pos = vec4(in_pos, 1.0f);
+  mod_pos.z += (180.f - mod_pos.y) * 0.01f;
+
+  pass_texcoord = offset + (tex_size *  mod_coord);
+  pass_color = in_color;
+
+  gl_Position = projection * view * in_mat * mod_pos;
+}
@@ -28,7 +28,7 @@ void main() {
     mod_coord.y = 1.0 - mod_coord.y;
   }
 
-  vec2 tex_size = vec2(raw_coord.w - raw_coord.y, raw_coord.z - raw_coord.x);
+  vec2 tex_size = vec2(raw_coord.z - raw_coord.x, raw_coord.w - raw_coord.y);
 
   vec2 offset = raw_coord.xy;
 
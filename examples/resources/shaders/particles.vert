@@ -24,7 +24,7 @@ void main() {
     vec2 mod_coord = in_texc;
     vec4 raw_coord = coords[gl_InstanceID];
 
-    vec2 tex_size = vec2(raw_coord.w - raw_coord.y, raw_coord.z - raw_coord.x);
+    vec2 tex_size = vec2(raw_coord.z - raw_coord.x, raw_coord.w - raw_coord.y);
     vec2 offset = raw_coord.xy;
     pass_texcoord = offset + (tex_size * mod_coord);
   }
@@ -0,0 +1,23 @@
+#version 330
+
+in vec2 pass_texcoord;
+in vec4 pass_color;
+
+uniform sampler2D sample_tex;
+
+out vec4 out_color;
+
+void main() {
+  // distance to the glyph's edge, 0.5 being on the edge
+  float dist = texture(sample_tex, pass_texcoord).a;
+
+  // keep the edge a pixel wide at any scale
+  float width = fwidth(dist);
+  float alpha = smoothstep(0.5 - width, 0.5 + width, dist);
+
+  if (alpha == 0) {
+    discard;
+  }
+
+  out_color = vec4(pass_color.rgb, pass_color.a * alpha);
+}
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include <astera/sys.h>
+#include <astera/asset.h>
 #include <astera/linmath.h>
 #include <stdint.h>
 
@@ -31,18 +32,145 @@ extern "C" {
 #define ASTERA_DEFAUT_SFX_RANGE 20
 #endif
 
+/* The size of a song's decode-ahead ring in multiples of its AL queue */
+#if !defined(ASTERA_SONG_RING_SCALE)
+#define ASTERA_SONG_RING_SCALE 2
+#endif
+
+/* The max number of OpenAL sources shared by sfx, sfx past this are virtual */
+#if !defined(ASTERA_AUDIO_MAX_VOICES)
+#define ASTERA_AUDIO_MAX_VOICES 32
+#endif
+
+/* Sfx quieter than this (gain * layer gain * distance) don't hold a source */
+#if !defined(ASTERA_AUDIO_MIN_AUDIBILITY)
+#define ASTERA_AUDIO_MIN_AUDIBILITY 0.001f
+#endif
+
+/* How much more audible a virtual sfx has to be to steal a playing voice */
+#if !defined(ASTERA_AUDIO_STEAL_RATIO)
+#define ASTERA_AUDIO_STEAL_RATIO 1.25f
+#endif
+
+/* How far past its range (as a fraction of it) an sfx goes before it's culled,
+ * culled sfx come back once they're within range again */
+#if !defined(ASTERA_AUDIO_CULL_MARGIN)
+#define ASTERA_AUDIO_CULL_MARGIN 0.1f
+#endif
+
+/* The fraction of its range past which a looping sfx drops its effect sends */
+#if !defined(ASTERA_AUDIO_LOD_DISTANCE)
+#define ASTERA_AUDIO_LOD_DISTANCE 0.75f
+#endif
+
+/* The number of commands that can be posted between updates (power of 2) */
+#if !defined(ASTERA_AUDIO_CMD_CAPACITY)
+#define ASTERA_AUDIO_CMD_CAPACITY 256
+#endif
+
+/* Default time in milliseconds between streaming thread updates */
+#if !defined(ASTERA_AUDIO_STREAM_INTERVAL)
+#define ASTERA_AUDIO_STREAM_INTERVAL 5
+#endif
+
+/* How far ahead (milliseconds) scheduled sfx are handed to OpenAL */
+#if !defined(ASTERA_AUDIO_SCHEDULE_LEAD)
+#define ASTERA_AUDIO_SCHEDULE_LEAD 100
+#endif
+
+/* The bytes of a WAV file read at once when streaming it */
+#if !defined(ASTERA_AUDIO_WAV_READ)
+#define ASTERA_AUDIO_WAV_READ 4096
+#endif
+
+/* Filter taps per phase when resampling sfx buffers (multiple of 4) */
+#if !defined(ASTERA_AUDIO_RESAMPLE_TAPS)
+#define ASTERA_AUDIO_RESAMPLE_TAPS 32
+#endif
+
+/* Max phases of the resampling filter, rates with no common step finer than
+ * this are rounded to the nearest phase */
+#if !defined(ASTERA_AUDIO_RESAMPLE_PHASES)
+#define ASTERA_AUDIO_RESAMPLE_PHASES 512
+#endif
+
+/* The max number of sfx variation groups in a context */
+#if !defined(ASTERA_AUDIO_GROUPS)
+#define ASTERA_AUDIO_GROUPS 32
+#endif
+
+/* The max number of buffers a variation group can pick between */
+#if !defined(ASTERA_AUDIO_GROUP_SIZE)
+#define ASTERA_AUDIO_GROUP_SIZE 8
+#endif
+
+/* The max sfx & songs a snapshot holds, past these they aren't rolled back */
+#if !defined(ASTERA_AUDIO_SNAPSHOT_SFX)
+#define ASTERA_AUDIO_SNAPSHOT_SFX 64
+#endif
+
+#if !defined(ASTERA_AUDIO_SNAPSHOT_SONGS)
+#define ASTERA_AUDIO_SNAPSHOT_SONGS 4
+#endif
+
+/* Bytes of decoded PCM uploaded to OpenAL per update for buffers nothing is
+ * waiting on yet, spreads a preload's uploads over several updates */
+#if !defined(ASTERA_AUDIO_UPLOAD_BUDGET)
+#define ASTERA_AUDIO_UPLOAD_BUDGET (4 * 1024 * 1024)
+#endif
+
+/* Bytes of a memory mapped song read in ahead of its decoder, again each time
+ * the decoder is halfway through them */
+#if !defined(ASTERA_AUDIO_MAP_PREFETCH)
+#define ASTERA_AUDIO_MAP_PREFETCH (256 * 1024)
+#endif
+
+/* Default max bytes of decoded OGG sfx kept in OpenAL buffers at once */
+#if !defined(ASTERA_AUDIO_PCM_BUDGET)
+#define ASTERA_AUDIO_PCM_BUDGET (64 * 1024 * 1024)
+#endif
+
 typedef struct {
   float gain;
   vec3  position, orientation, velocity;
   float _ori[6];
 } a_listener;
 
+typedef enum {
+  A_BUF_EMPTY = 0, // not decoded, decodes on its next play
+  A_BUF_QUEUED,    // waiting on the decode thread
+  A_BUF_LOADING,   // waiting on the decode thread to read it from a pak
+  A_BUF_DECODING,  // being decoded by the decode thread
+  A_BUF_DECODED,   // decoded, waiting on a_ctx_update to upload it
+  A_BUF_READY,     // in OpenAL & playable
+  A_BUF_FAILED,    // unable to decode
+} a_buf_state;
+
 typedef struct {
   uint16_t id;
   uint32_t buf;
   uint16_t channels;
   uint32_t length;
   uint32_t sample_rate;
+
+  /* ogg - a copy of the OGG file to decode from (0 for WAV)
+   * ogg_length - the length of the OGG file in bytes
+   * checksum - FNV-1a of the OGG file, the key for the PCM cache on disk
+   * pcm - decoded samples waiting to be uploaded
+   * state - where the buffer is in decoding (a_buf_state)
+   * users - the number of sfx playing the buffer
+   * bytes - the size of the decoded PCM held in OpenAL
+   * last_use - when the buffer was last played, for eviction
+   * pak - the pak a preloading buffer is read from (0 once read)
+   * pak_index - the entry in the pak to read */
+  unsigned char*    ogg;
+  uint32_t          ogg_length, checksum;
+  int16_t*          pcm;
+  volatile uint32_t state;
+  uint16_t          users;
+  uint32_t          bytes, last_use;
+  pak_t*            pak;
+  uint32_t          pak_index;
 } a_buf;
 
 typedef enum {
@@ -119,6 +247,21 @@ typedef struct {
   } data;
 } a_filter;
 
+typedef struct {
+  /* The request values last sent to a source, so only changes are sent
+   * valid - 0 when the source needs everything sent again */
+  vec3    position, velocity;
+  float   gain, range, pitch;
+  uint8_t loop, valid;
+} a_source_cache;
+
+typedef struct {
+  /* layer - the ID of the layer holding this song/sfx (0 = none)
+   * prev - the previous song/sfx ID in the layer's list (0 = none)
+   * next - the next song/sfx ID in the layer's list (0 = none) */
+  uint16_t layer, prev, next;
+} a_layer_link;
+
 typedef struct {
   /* FIXED:
    * these variables are only used at initialization
@@ -128,6 +271,14 @@ typedef struct {
   uint16_t *fx, *filters;
   uint16_t  fx_count, filter_count;
 
+  /* group - a variation group to pick the sfx's buffer from (0 = none)
+   * pitch_range - how far the pitch can be randomly moved from 1, either way
+   * gain_range - how far the gain can be randomly scaled from 1, either way
+   * NOTE: variations are picked each time the request is played (sfx only)
+   */
+  uint16_t group;
+  float    pitch_range, gain_range;
+
   /* DYNAMIC:
    * these variables affect the song / sound in real time
 
@@ -141,6 +292,10 @@ typedef struct {
   /* max_loop - the max amount of times the sound/song can loop */
   uint16_t max_loop;
 
+  /* priority - sfx with a higher priority keep their voice over louder ones
+   *            with a lower priority (default 0) */
+  uint8_t priority;
+
   /* loop - if the sound/song should loop (1 = true, 0 = false)
    * stop - if the sound/song should stop (1 = true, 0 = false)
    * destroy - if the sound/song should be destroyed (1 = true, 0 = false) */
@@ -158,6 +313,27 @@ typedef struct {
   int32_t  state;
 } a_req;
 
+typedef struct {
+  /* file - the file being streamed from (FILE*, 0 = streaming from data)
+   * data - the memory being streamed from
+   * base - where the WAV file starts in the file / data
+   * size - the size of the WAV file in bytes
+   * pcm_offset - where the PCM starts, from base
+   * pcm_length - the length of the PCM in bytes
+   * read - the bytes of PCM read so far
+   * bits - the bits per sample (8 or 16)
+   * raw - staging for PCM read out of the file / data */
+  void*                file;
+  const unsigned char* data;
+  uint32_t             base, size;
+  uint32_t             pcm_offset, pcm_length, read;
+  uint16_t             bits;
+  unsigned char        raw[ASTERA_AUDIO_WAV_READ];
+} a_wav;
+
+/* A song's software effects, when there's no EFX to run them */
+typedef struct a_dsp_t a_dsp;
+
 typedef struct {
   /* id - the ID for this song in an a_ctx */
   uint16_t id;
@@ -181,25 +357,91 @@ typedef struct {
   time_s delta, length, curr;
 
   /* vorbis - the STB_Vorbis handle for OGG Decoding
-   * info - the stb vorbis info handle */
+   * wav - the WAV file being streamed (0 for OGG songs)
+   * info - the stb vorbis info handle (only rate & channels for WAV) */
   stb_vorbis*     vorbis;
+  a_wav*          wav;
   stb_vorbis_info info;
 
   /* sample_count - the total number of samples in the vorbis stream
    * sample_offset - the overall offset of the buffer */
   uint32_t sample_count, sample_offset;
 
-  /* packets_per_buffer - the amount of packets to decode per buffer */
+  /* packets_per_buffer - the amount of packets to decode per buffer
+   * buffer_samples - the number of samples decoded per buffer */
   uint16_t packets_per_buffer;
+  uint32_t buffer_samples;
+
+  /* pcm - the song's own float decode buffer (buffer_samples long)
+   * pcm16 - where pcm is converted to 16 bit (0 with AL_EXT_float32) */
+  float*   pcm;
+  int16_t* pcm16;
 
-  /* data - the raw data of the OGG Vorbis track */
+  /* data - the raw data of the OGG Vorbis track
+   * map - the file data is mapped from (0 = data is owned by the caller)
+   * prefetched - the end of the window last read in ahead (offset in data) */
   uint8_t* data;
+  s_map    map;
+  uint64_t prefetched;
+
+  /* dsp - the software effect chain run on the song without EFX (0 = none) */
+  a_dsp* dsp;
 
   /* req - where & how to play the song */
   a_req* req;
 
   /* loop - if the song should loop or not */
   uint8_t loop;
+
+  /* link - the song's place in its layer
+   * sent - the values last sent to the song's source */
+  a_layer_link   link;
+  a_source_cache sent;
+
+  /* ring - decode-ahead float PCM filled by the streaming thread
+   * ring_length - the number of samples in the ring (power of 2)
+   * ring_head - the total samples written into the ring
+   * ring_tail - the total samples read out of the ring */
+  float*            ring;
+  uint32_t          ring_length;
+  volatile uint32_t ring_head, ring_tail;
+
+  /* playing - if the song should be playing (restarted on underrun)
+   * paused - if the song is paused, holding back the sfx scheduled on it
+   * decoded - if the vorbis stream has been decoded to its end */
+  uint8_t playing, paused, decoded;
+
+  /* fade - the gain the song's fade puts on top of its request
+   * fade_from - the fade's gain at its start
+   * fade_to - the fade's gain at its end
+   * fade_start - when the fade started (milliseconds)
+   * fade_length - how long the fade takes (milliseconds)
+   * fading - if the song is fading
+   * fade_stop - if the song stops once its fade is done */
+  float   fade, fade_from, fade_to;
+  time_s  fade_start, fade_length;
+  uint8_t fading, fade_stop;
+
+  /* OBSERVATIONAL:
+   * samples_decoded - the total samples decoded for the song
+   * underruns - the number of times the song's queue ran dry
+   * last_underrun - when the queue last ran dry (s_get_time, milliseconds)
+   * queued - the buffers still queued at the last refill (0 = starved)
+   * starved - if the queue is still dry from the last counted underrun */
+  uint32_t samples_decoded, underruns;
+  time_s   last_underrun;
+  uint8_t  queued, starved;
+
+  /* starting - if the song is priming its queue to start a crossfade
+   * priming - the number of queue buffers left to decode before starting
+   * fade_partner - the song to fade out once this one starts (0 = none) */
+  uint8_t           starting;
+  volatile uint32_t priming;
+  uint16_t          fade_partner;
+
+  /* orphan - played since the snapshot last restored, stopped on the next
+   *          update unless it's played again */
+  uint8_t orphan;
 } a_song;
 
 typedef struct {
@@ -215,6 +457,40 @@ typedef struct {
 
   /* req - the request attached */
   a_req* req;
+
+  /* audibility - gain * layer gain * distance attenuation at last update
+   * paused - if the sfx is paused
+   * NOTE: an sfx with a buffer but no source is virtual, its time is kept
+   *       in req->time until it's audible enough to get a voice back */
+  float   audibility;
+  uint8_t paused;
+
+  /* pitch - the pitch picked when played (req->pitch_range)
+   * gain_scale - the scale on req->gain picked when played (req->gain_range)
+   */
+  float pitch, gain_scale;
+
+  /* culled - if the sfx is out of range, culled sfx are kept virtual
+   * lod - if the sfx is far enough to play without its effect sends */
+  uint8_t culled, lod;
+
+  /* scheduled - if the sfx is waiting to start
+   * start - the mixer sample it starts on
+   * start_song - the song it starts with (0 = none)
+   * start_time - the song's time (milliseconds) it starts at */
+  uint8_t  scheduled;
+  uint64_t start;
+  uint16_t start_song;
+  time_s   start_time;
+
+  /* link - the sfx's place in its layer
+   * sent - the values last sent to the sfx's source */
+  a_layer_link   link;
+  a_source_cache sent;
+
+  /* orphan - played since the snapshot last restored, released on the next
+   *          update unless it's played again */
+  uint8_t orphan;
 } a_sfx;
 
 typedef struct {
@@ -222,7 +498,9 @@ typedef struct {
 
   const char* name;
 
-  uint32_t *sfx, *songs;
+  /* sfx_head - the first sfx ID in the layer's list (0 = empty)
+   * song_head - the first song ID in the layer's list (0 = empty) */
+  uint16_t sfx_head, song_head;
 
   uint32_t sfx_count, sfx_capacity;
   uint32_t song_count, song_capacity;
@@ -230,7 +508,99 @@ typedef struct {
   float gain;
 } a_layer;
 
+typedef enum {
+  A_CMD_NONE = 0,
+  A_CMD_SFX_PLAY,
+  A_CMD_SFX_STOP,
+  A_CMD_SFX_PAUSE,
+  A_CMD_SFX_RESUME,
+  A_CMD_SONG_PLAY,
+  A_CMD_SONG_STOP,
+  A_CMD_SONG_PAUSE,
+  A_CMD_SONG_RESUME,
+  A_CMD_LAYER_GAIN,
+  A_CMD_LISTENER_GAIN,
+  A_CMD_LISTENER_POS,
+  A_CMD_LISTENER_VEL,
+  A_CMD_LISTENER_ORI,
+} a_cmd_type;
+
+typedef struct {
+  /* type - the call this command stands in for
+   * id - the buffer (play), sfx or song ID the command acts on
+   * layer - the layer to play on or set the gain of
+   * req - the request to play with */
+  a_cmd_type type;
+  uint16_t   id, layer;
+  a_req*     req;
+
+  /* gain - layer or listener gain
+   * values - listener position / velocity (3) or orientation (6) */
+  float gain;
+  float values[6];
+} a_cmd;
+
 // See audio.c for a_ctx definition
+typedef struct {
+  /* update_time - milliseconds the last a_ctx_update took
+   * decode_time - milliseconds spent decoding songs during the last frame
+   *               (on the streaming thread while it's running)
+   * dsp_time - milliseconds of decode_time spent on software effects
+   * samples_decoded - song samples decoded during the last frame */
+  time_s   update_time, decode_time, dsp_time;
+  uint32_t samples_decoded;
+
+  /* underruns - the number of times any song's queue has run dry
+   * last_underrun - when a queue last ran dry (s_get_time, milliseconds)
+   * last_underrun_song - the song whose queue last ran dry (0 = none) */
+  uint32_t underruns;
+  time_s   last_underrun;
+  uint16_t last_underrun_song;
+
+  /* voices - sfx holding an OpenAL source
+   * virtual_voices - sfx without a source (inaudible, culled or waiting)
+   * culled - virtual sfx that are out of range */
+  uint16_t voices, virtual_voices, culled;
+
+  /* al_calls - OpenAL source calls made between the last two updates */
+  uint32_t al_calls;
+
+  /* fx_used / fx_capacity - effect slots in use / available
+   * filters_used / filter_capacity - filter slots in use / available */
+  uint16_t fx_used, fx_capacity;
+  uint16_t filters_used, filter_capacity;
+} a_stats;
+
+typedef struct {
+  /* req - the request played with, matched by address on restore
+   * values - the request's values when the snapshot was taken
+   * pitch / gain_scale - the variation the sfx picked
+   * id - the ID of the sfx / song
+   * layer - the layer it was in (0 = none)
+   * buffer - the buffer the sfx played (0 for songs)
+   * paused - if it was paused */
+  a_req*   req;
+  a_req    values;
+  float    pitch, gain_scale;
+  uint16_t id, layer, buffer;
+  uint8_t  paused;
+} a_snapshot_voice;
+
+/* The logical state of a context's playback, plain data so it can be kept
+ * by value (i.e a ring of them, one per frame) */
+typedef struct {
+  /* time - the context's clock as of the last update (milliseconds)
+   * rng - the state of the RNG variations are picked with
+   * group_last - the last pick of each variation group
+   * sfx_count / song_count - the number of sfx / songs held */
+  time_s           time;
+  uint32_t         rng;
+  uint16_t         group_last[ASTERA_AUDIO_GROUPS];
+  uint16_t         sfx_count, song_count;
+  a_snapshot_voice sfx[ASTERA_AUDIO_SNAPSHOT_SFX];
+  a_snapshot_voice songs[ASTERA_AUDIO_SNAPSHOT_SONGS];
+} a_snapshot;
+
 typedef struct a_ctx a_ctx;
 
 /* Print various info about the OpenAL EFX Extension capabilities on this
@@ -243,6 +613,12 @@ void a_efx_info(a_ctx* ctx);
  * returns: a pointer to the string */
 const char* a_ctx_get_device(a_ctx* ctx, uint8_t* string_length);
 
+/* Get the profiling counters of a context, collected each a_ctx_update
+ * ctx - the context to check
+ * returns: the counters as of the last update
+ * NOTE: per song queue depth & underruns are kept on each a_song */
+a_stats a_ctx_get_stats(a_ctx* ctx);
+
 /* Check if the context is allowing playback
  * returns 1 = yes, 0 = no */
 uint8_t a_can_play(a_ctx* ctx);
@@ -254,11 +630,33 @@ uint8_t a_can_play(a_ctx* ctx);
  * max_buffers - the max amount of audio buffers for the context to handle
  * max_fx - the max amount of audio fx for the context to handle
  * max_songs - the max amount of songs for the context to handle
- * pcm_size - the size of the PCM buffer for OGG vorbis decoding */
+ * pcm_size - the max samples each song decodes per OpenAL buffer */
 a_ctx* a_ctx_create(const char* device, uint8_t layers, uint16_t max_sfx,
                     uint16_t max_buffers, uint16_t max_songs, uint16_t max_fx,
                     uint16_t max_filters, uint32_t pcm_size);
 
+/* Create an audio context that mixes into memory instead of a device using
+ * ALC_SOFT_loopback, nothing plays until a_ctx_render is called
+ * sample_rate - the sample rate to render at
+ * channels - the number of channels to render (1 or 2)
+ * (see a_ctx_create for the rest)
+ * returns: the context, 0 = fail (no loopback support / format)
+ * NOTE: virtual sfx time follows the rendered time, so output depends only
+ *       on the calls made & not on wall clock time */
+a_ctx* a_ctx_create_loopback(uint32_t sample_rate, uint8_t channels,
+                             uint8_t layers, uint16_t max_sfx,
+                             uint16_t max_buffers, uint16_t max_songs,
+                             uint16_t max_fx, uint16_t max_filters,
+                             uint32_t pcm_size);
+
+/* Mix audio from a loopback context
+ * ctx - the loopback context
+ * dst - where to write the interleaved 16 bit samples
+ *       (frames * channels samples)
+ * frames - the number of sample frames to render
+ * returns: 1 = success, 0 = fail */
+uint8_t a_ctx_render(a_ctx* ctx, int16_t* dst, uint32_t frames);
+
 /* Destroy the Audio Context & all of it's contents */
 uint8_t a_ctx_destroy(a_ctx* ctx);
 
@@ -266,14 +664,113 @@ uint8_t a_ctx_destroy(a_ctx* ctx);
  * ctx - the context to update */
 void a_ctx_update(a_ctx* ctx);
 
+/* Post a command to be run on the next a_ctx_update
+ * ctx - the context to post to
+ * cmd - the command to run
+ * returns: 1 = success, 0 = fail (queue full)
+ * NOTE: safe to call from any number of threads at once, the commands are
+ *       run in a single batch by whichever thread calls a_ctx_update.
+ *       Queued plays have no ID to return, use the request to observe &
+ *       stop them. Setting the request's stop before the play has run
+ *       cancels it, the request's state reads AL_STOPPED once it's dropped */
+uint8_t a_ctx_post(a_ctx* ctx, a_cmd cmd);
+
+/* Start a thread that owns song decoding & refills their OpenAL queues
+ * ctx - the context to stream songs for
+ * interval - milliseconds between refills (0 for default)
+ * returns: 1 = success, 0 = fail
+ * NOTE: while running, a_ctx_update no longer decodes songs, so music keeps
+ *       playing through long frames on the calling thread */
+uint8_t a_ctx_start_stream(a_ctx* ctx, time_s interval);
+
+/* Stop the streaming thread & return song decoding to a_ctx_update
+ * ctx - the context streaming songs
+ * returns: 1 = success, 0 = fail */
+uint8_t a_ctx_stop_stream(a_ctx* ctx);
+
+/* Set if sfx buffers are converted to the device's rate when created, so
+ * OpenAL doesn't resample every voice playing them as it mixes
+ * ctx - the context to set
+ * resample - 1 = convert buffers created from now on, 0 = keep their rates
+ * returns: 1 = success, 0 = fail
+ * NOTE: converted buffers are 16 bit, channels are kept as they are since
+ *       only mono buffers are positioned. OGG buffers are converted as
+ *       they're decoded, on the decode thread */
+uint8_t a_ctx_set_resample(a_ctx* ctx, uint8_t resample);
+
+/* Set where & how much decoded OGG sfx are cached
+ * ctx - the context to set the cache of
+ * directory - a directory to save decoded PCM to, so later runs can skip
+ *             decoding (optional, 0 = none, must outlive the context)
+ * budget - the max bytes of decoded PCM to keep in OpenAL buffers, least
+ *          recently played buffers past it are dropped until played again
+ *          (0 for default)
+ * returns: 1 = success, 0 = fail
+ * NOTE: OGG buffers decode on their first play, on a background thread.
+ *       Call this before playing any so the directory is picked up */
+uint8_t a_ctx_set_pcm_cache(a_ctx* ctx, const char* directory,
+                            uint32_t budget);
+
+/* Seed the random numbers sfx variations are picked with
+ * ctx - the context to seed
+ * seed - the seed to use (the same seed picks the same variations)
+ * returns: 1 = success, 0 = fail */
+uint8_t a_ctx_set_seed(a_ctx* ctx, uint32_t seed);
+
 /* Queue up a SFX to play
  * ctx - the context to play the SFX within
  * layer - a layer to use to manage this sfx (optional, 0 for none)
- * buf_id - the audio buffer ID of the sound data
+ * buf_id - the audio buffer ID of the sound data (ignored if req->group)
  * req - the request callback for specifics of where / how to play the sfx
- * returns: the ID of the sfx (non-zero, 0 = error) */
+ * returns: the ID of the sfx (non-zero, 0 = error)
+ * NOTE: when every voice is taken the least important one (priority, then
+ *       audibility) is stolen, or the sfx starts out virtual */
 uint16_t a_sfx_play(a_ctx* ctx, uint16_t layer, uint16_t buf_id, a_req* req);
 
+/* Play a batch of SFX, all starting in the same mixer period
+ * ctx - the context to play the SFX within
+ * layer - a layer to use to manage the sfx (optional, 0 for none)
+ * buf_ids - the audio buffer ID for each sfx
+ * reqs - the request for each sfx (must outlive the sfx like with a_sfx_play)
+ * count - the number of sfx to play
+ * ids - where to write the ID of each sfx, 0 for any that failed (optional)
+ * returns: the number of sfx played
+ * NOTE: slots are taken in one pass & every sfx that gets a voice is
+ *       started with one alSourcePlayv */
+uint16_t a_sfx_play_many(a_ctx* ctx, uint16_t layer, const uint16_t* buf_ids,
+                         a_req* reqs, uint16_t count, uint16_t* ids);
+
+/* Get the position of the mixer
+ * ctx - the context to get the position of
+ * returns: the number of sample frames mixed since the context was created */
+uint64_t a_ctx_get_sample(a_ctx* ctx);
+
+/* Schedule a SFX to start on a mixer sample
+ * ctx - the context to play the SFX within
+ * layer - a layer to use to manage this sfx (optional, 0 for none)
+ * buf_id - the audio buffer ID of the sound data
+ * req - the request callback for specifics of where / how to play the sfx
+ * sample - the mixer sample to start on (see a_ctx_get_sample)
+ * returns: the ID of the sfx (non-zero, 0 = error)
+ * NOTE: req->state is AL_INITIAL until it starts. Starts are sample accurate
+ *       with AL_SOFT_source_start_delay & on loopback contexts, otherwise
+ *       they're made on the first update after the sample, skipping ahead
+ *       so the sfx stays in time. Samples already passed start right away */
+uint16_t a_sfx_play_at(a_ctx* ctx, uint16_t layer, uint16_t buf_id,
+                       a_req* req, uint64_t sample);
+
+/* Schedule a SFX to start when a song reaches a time
+ * ctx - the context to play the SFX within
+ * layer - a layer to use to manage this sfx (optional, 0 for none)
+ * buf_id - the audio buffer ID of the sound data
+ * req - the request callback for specifics of where / how to play the sfx
+ * song_id - the song to follow
+ * song_time - the time in the song to start at (milliseconds, a_song_get_time)
+ * returns: the ID of the sfx (non-zero, 0 = error)
+ * NOTE: waits while the song is paused & is dropped if the song stops */
+uint16_t a_sfx_play_on_song(a_ctx* ctx, uint16_t layer, uint16_t buf_id,
+                            a_req* req, uint16_t song_id, time_s song_time);
+
 /* Stops and removes the SFX from it's slot
  * ctx - the context to use to find the sfx
  * sfx_id - the ID of the SFX returned when played
@@ -292,17 +789,86 @@ uint8_t a_sfx_pause(a_ctx* ctx, uint16_t sfx_id);
  * returns: success = 1, fail = 0 */
 uint8_t a_sfx_resume(a_ctx* ctx, uint16_t sfx_id);
 
+/* Take a snapshot of which sfx & songs are playing or paused, for rollback
+ * ctx - the context to snapshot
+ * snapshot - the snapshot to write to
+ * returns: 1 = success, 0 = fail
+ * NOTE: no OpenAL calls are made, offsets are as of the last update */
+uint8_t a_ctx_snapshot(a_ctx* ctx, a_snapshot* snapshot);
+
+/* Roll playback back to a snapshot, without restarting what's still right
+ * ctx - the context to restore
+ * snapshot - the snapshot to restore to
+ * returns: 1 = success, 0 = fail
+ * NOTE: sfx / songs in both keep playing untouched, ones paused or resumed
+ *       since are put back. Ones cut off since come back in where they'd be
+ *       by now (paused ones where they were paused). Ones played since are
+ *       held until the next a_ctx_update, playing the same request again
+ *       while re-simulating picks them back up, the rest are stopped.
+ *       Variation picks are rolled back too */
+uint8_t a_ctx_restore(a_ctx* ctx, const a_snapshot* snapshot);
+
 /* Create a song
  * ctx - the context to create the song within
  * data - the raw (OGG Vorbis) file data
  * length - the length of the raw data
  * packets_per_buffer - the amount of packets to put into a buffer
  * buffers - the number of OpenAL buffers to use
+ * max_buffer_size - the max samples to decode per buffer
  * returns: the song ID (non-zero = success, 0 = fail) */
 uint16_t a_song_create(a_ctx* ctx, unsigned char* data, uint32_t data_length,
                        const char* name, uint16_t packets_per_buffer,
                        uint8_t buffers, uint32_t max_buffer_size);
 
+/* Create a song that decodes an OGG Vorbis file straight out of a memory
+ * mapping of it
+ * ctx - the context to create the song within
+ * path - the path of the OGG Vorbis file
+ * name - a string name for the song (optional)
+ * (see a_song_create for the rest)
+ * returns: the song ID (non-zero = success, 0 = fail)
+ * NOTE: only the pages the decoder touches are read in, leaving what stays
+ *       resident up to the OS's page cache */
+uint16_t a_song_create_file(a_ctx* ctx, const char* path, const char* name,
+                            uint16_t packets_per_buffer, uint8_t buffers,
+                            uint32_t max_buffer_size);
+
+/* Create a song that decodes an OGG Vorbis pak entry in place
+ * ctx - the context to create the song within
+ * pak - the pak holding the OGG Vorbis file (must outlive the song)
+ * index - the index of the entry in the pak
+ * name - a string name for the song (optional)
+ * (see a_song_create for the rest)
+ * returns: the song ID (non-zero = success, 0 = fail)
+ * NOTE: paks opened from a file are memory mapped for each song, paks in
+ *       memory are decoded from without a copy */
+uint16_t a_song_create_pak(a_ctx* ctx, pak_t* pak, uint32_t index,
+                           const char* name, uint16_t packets_per_buffer,
+                           uint8_t buffers, uint32_t max_buffer_size);
+
+/* Create a song that streams a WAV file out of an asset
+ * ctx - the context to create the song within
+ * asset - the asset holding the WAV file (must outlive the song)
+ * name - a string name for the song (optional)
+ * buffers - the number of OpenAL buffers to use
+ * max_buffer_size - the max samples to read per buffer
+ * returns: the song ID (non-zero = success, 0 = fail)
+ * NOTE: only 8 & 16 bit PCM, mono or stereo */
+uint16_t a_song_create_wav(a_ctx* ctx, asset_t* asset, const char* name,
+                           uint8_t buffers, uint32_t max_buffer_size);
+
+/* Create a song that streams a WAV file out of a pak entry
+ * ctx - the context to create the song within
+ * pak - the pak holding the WAV file (must outlive the song)
+ * index - the index of the entry in the pak
+ * (see a_song_create_wav for the rest)
+ * returns: the song ID (non-zero = success, 0 = fail)
+ * NOTE: paks opened from a file are read as the song plays, so only the
+ *       queue is ever held in memory */
+uint16_t a_song_create_wav_pak(a_ctx* ctx, pak_t* pak, uint32_t index,
+                               const char* name, uint8_t buffers,
+                               uint32_t max_buffer_size);
+
 /* Destroy a song & it's contents
  * ctx - the context the song is contained within
  * id - the ID of the song from creation */
@@ -322,6 +888,20 @@ a_song* a_song_get_ptr(a_ctx* ctx, uint16_t song_id);
 uint8_t a_song_play(a_ctx* ctx, uint16_t layer_id, uint16_t song_id,
                     a_req* req);
 
+/* Crossfade from one song to another
+ * ctx - the context the songs are within
+ * from_id - the song to fade out (optional, 0 to only fade in)
+ * to_id - the song to fade in from its start
+ * layer_id - the layer to play the incoming song on (optional, 0 for none)
+ * req - the request on where / how to play the incoming song
+ * duration - how long the crossfade takes (milliseconds)
+ * returns: 1 = success, 0 = fail
+ * NOTE: the incoming song's queue is decoded a buffer per update (or per
+ *       streaming pass) before the fade starts, so the switch doesn't stall.
+ *       The outgoing song is stopped once it's faded out */
+uint8_t a_song_crossfade(a_ctx* ctx, uint16_t from_id, uint16_t to_id,
+                         uint16_t layer_id, a_req* req, time_s duration);
+
 /* Stop a song & reset it
  * ctx - the context that contains the song
  * song_id - the ID of the song returned on creation
@@ -387,7 +967,8 @@ uint16_t a_song_get_id(a_ctx* ctx, const char* name);
  * data_length - the length of the raw data
  * name - a string name for the buffer (optional)
  * is_ogg - if you want to decode using OGG or WAV format (1 = ogg, 0 = wav)
- * returns: ID of the buffer in the context (non-zero, 0 = fail) */
+ * returns: ID of the buffer in the context (non-zero, 0 = fail)
+ * NOTE: OGG data is copied & only decoded once the buffer is first played */
 uint16_t a_buf_create(a_ctx* ctx, unsigned char* data, uint32_t data_length,
                       const char* name, uint8_t is_ogg);
 
@@ -397,6 +978,31 @@ uint16_t a_buf_create(a_ctx* ctx, unsigned char* data, uint32_t data_length,
  * returns: success = 1, fail = 0 */
 uint8_t a_buf_destroy(a_ctx* ctx, uint16_t buf_id);
 
+/* Create audio buffers from pak entries, loading them in the background
+ * ctx - the context to create the buffers in
+ * pak - the pak to read from (must outlive the loading)
+ * names - the names of the entries (OGG or WAV), also used as the buffers'
+ *         names (must outlive the buffers)
+ * count - the number of names
+ * ids - the buffer ID for each name (0 = not found / no free slot)
+ * returns: the number of buffers created
+ * NOTE: entries are read, decoded & resampled on the decode thread, only
+ *       their upload happens in a_ctx_update. Buffers can be played while
+ *       they load, sfx wait on them virtually. Check on them with
+ *       a_buf_preload_poll */
+uint16_t a_buf_preload(a_ctx* ctx, pak_t* pak, const char** names,
+                       uint16_t count, uint16_t* ids);
+
+/* Check on buffers created by a_buf_preload
+ * ctx - the context the buffers are in
+ * ids - the buffer IDs a_buf_preload returned
+ * count - the number of IDs
+ * failed - the number of buffers unable to load (optional)
+ * returns: the number of buffers done loading, ready or failed (0 IDs
+ *          count as failed) */
+uint16_t a_buf_preload_poll(a_ctx* ctx, const uint16_t* ids, uint16_t count,
+                            uint16_t* failed);
+
 /* Find an audio buffer by name
  * ctx - the context that contains the audio buffer
  * name - the name of the audio buffer */
@@ -473,7 +1079,11 @@ a_req a_req_create(vec3 position, float gain, float range, uint8_t loop,
  * ctx - the context to use
  * type - the type of effect to create
  * data - a pointer to the effect data
- * returns: the ID of the effect */
+ * returns: the ID of the effect
+ *
+ * NOTE: without EFX (i.e macOS or ASTERA_AL_NO_FX) effects are run in
+ * software, and only on songs, sfx play without them. The data pointer
+ * has to stay valid while the effect is in use */
 uint16_t a_fx_create(a_ctx* ctx, a_fx_type type, void* data);
 
 /* Remove an effect & free up the slot
@@ -529,7 +1139,9 @@ a_fx_eq a_fx_eq_create(float low_gain, float low_cutoff, float mid1_gain,
  * returns: the formatted filter structure
  *
  * NOTE: you only have to use the HF / LF if the type of filter you're using
- * requires them otherwise the values are ignored */
+ * requires them otherwise the values are ignored
+ *
+ * NOTE: like effects, without EFX filters are run in software on songs only */
 uint16_t a_filter_create(a_ctx* ctx, a_filter_type type, float gain, float hf,
                          float lf);
 
@@ -550,6 +1162,28 @@ uint8_t a_filter_destroy(a_ctx* ctx, uint16_t filter_id);
  * returns: the filter slot */
 a_filter* a_filter_get_slot(a_ctx* ctx, uint16_t filter_id);
 
+/* Create a variation group, sfx played with it pick one of its buffers at
+ * random (never the same one twice in a row)
+ * ctx - the context to create the group in
+ * name - the name of the group (must outlive the group)
+ * buf_ids - the buffers to pick between
+ * count - the number of buffers (max ASTERA_AUDIO_GROUP_SIZE)
+ * returns: the ID of the group (non-zero, 0 = fail) */
+uint16_t a_group_create(a_ctx* ctx, const char* name, const uint16_t* buf_ids,
+                        uint16_t count);
+
+/* Get the ID of a variation group by name
+ * ctx - the context to check
+ * name - the name of the group
+ * returns: the ID of the group (non-zero, 0 = fail) */
+uint16_t a_group_get(a_ctx* ctx, const char* name);
+
+/* Destroy a variation group (the buffers in it are left alone)
+ * ctx - the context the group is in
+ * group_id - the ID of the group
+ * returns: 1 = success, 0 = fail */
+uint8_t a_group_destroy(a_ctx* ctx, uint16_t group_id);
+
 /* Create a layer to hold resources and modify them in groups
  * ctx - the audio context to use
  * name - the name of the layer
@@ -571,14 +1205,14 @@ uint16_t a_layer_get_id(a_ctx* ctx, const char* name);
  * returns: 1 = success, 0 = fail */
 uint8_t a_layer_destroy(a_ctx* ctx, uint16_t layer_id);
 
-/* Add an sfx to a layer
+/* Add an sfx to a layer (moving it out of any other layer)
  * ctx - the context to use
  * layer_id - the ID of the layer to modify
  * sfx_id - the ID of the sfx to add
  * returns: 1 = success, 0 = fail */
 uint8_t a_layer_add_sfx(a_ctx* ctx, uint16_t layer_id, uint16_t sfx_id);
 
-/* Add a song to a layer
+/* Add a song to a layer (moving it out of any other layer)
  * ctx - the context to use
  * layer_id - the ID of the layer to modify
  * song_id - the ID of the song to add
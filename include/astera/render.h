@@ -20,6 +20,21 @@ extern "C" {
 #define ASTERA_RENDER_LAYER_MOD 0.01f
 #endif
 
+// The width in pixels of SDF glyph atlases (height is fit to the glyphs)
+#if !defined(ASTERA_RENDER_FONT_ATLAS_WIDTH)
+#define ASTERA_RENDER_FONT_ATLAS_WIDTH 512
+#endif
+
+// The padding in pixels around each SDF glyph (the distance field's range)
+#if !defined(ASTERA_RENDER_FONT_SDF_PADDING)
+#define ASTERA_RENDER_FONT_SDF_PADDING 4
+#endif
+
+// The max amount of batches gathered into one multi draw indirect submit
+#if !defined(ASTERA_RENDER_INDIRECT_SHEETS)
+#define ASTERA_RENDER_INDIRECT_SHEETS 16
+#endif
+
 typedef struct {
   /* vao - OpenGL Vertex Array object
    * vbo - OpenGL Vertex Buffer Object
@@ -148,6 +163,11 @@ typedef struct {
   /* coords - the min max values of the sub texture
    *          [min_x, min_y, max_x, max_y] */
   vec4 coords;
+
+  /* opaque - if the sub texture has no partially transparent pixels, so it
+   *          can be drawn in the opaque pass without blending
+   *          NOTE: fully transparent pixels are discarded by the shaders */
+  uint8_t opaque;
 } r_subtex;
 
 typedef struct {
@@ -201,6 +221,32 @@ typedef struct {
   mat4x4 model;
 } r_baked_sheet;
 
+typedef struct {
+  /* subtex - the ID of the glyph's sub texture in the font's sheet
+   * advance - the amount to move the pen after the glyph (pixels)
+   * x_off - the x offset of the glyph's top left from the pen (pixels)
+   * y_off - the y offset of the glyph's top left from the baseline (pixels) */
+  uint32_t subtex;
+  float    advance, x_off, y_off;
+} r_glyph;
+
+typedef struct {
+  /* sheet - the SDF glyph atlas, each glyph being a sub texture
+   * glyphs - the metrics of each glyph (index = codepoint - first) */
+  r_sheet  sheet;
+  r_glyph* glyphs;
+
+  /* first - the first codepoint in the atlas
+   * count - the number of codepoints in the atlas */
+  uint32_t first, count;
+
+  /* size - the pixel height the glyphs were generated at
+   * ascent - the distance from the baseline to the top (pixels)
+   * descent - the distance from the baseline to the bottom (pixels)
+   * line_gap - the spacing between lines (pixels) */
+  float size, ascent, descent, line_gap;
+} r_font;
+
 /* I think this is relatively self explanatory */
 typedef enum {
   R_ANIM_STOP  = 0,
@@ -232,13 +278,32 @@ typedef struct {
   int8_t loop;
 } r_anim;
 
-// Internal animation viewer type
+// A clock shared between sprites playing the same animation in sync
 typedef struct {
-  r_anim*  anim;
-  time_s   time, rate;
-  uint32_t curr, count;
+  /* anim - the animation the clock steps through
+   * time - the time into the animation (milliseconds)
+   * length - the total length of the animation (milliseconds) */
+  r_anim* anim;
+  time_s  time, length;
+
+  /* curr - the current index of frame (at 0 phase)
+   * state - the playback state of the clock
+   * pstate - the previous playback state of the clock
+   * loop - 1 = yes, 0 = no */
+  uint32_t curr;
   uint8_t  state, pstate;
   int8_t   loop;
+} r_anim_clock;
+
+// Internal animation viewer type
+// NOTE: if clock is set, the frame is read from the clock at time + phase
+typedef struct {
+  r_anim*       anim;
+  r_anim_clock* clock;
+  time_s        time, rate, phase;
+  uint32_t      curr, count;
+  uint8_t       state, pstate;
+  int8_t        loop;
 } r_anim_viewer;
 
 typedef struct {
@@ -299,6 +364,9 @@ typedef struct {
   r_shader shader;
   r_sheet* sheet;
 
+  // If the batch is drawn in the opaque pass (front to back, no blending)
+  uint8_t opaque;
+
   // Uniform Arrays
   mat4x4* mats;
   int*    flip_x;
@@ -309,8 +377,25 @@ typedef struct {
   uint32_t count, capacity;
   uint8_t  use_ubo;
   r_ubo    ubo;
+
+  // Depth sort scratch, allocated on the first sort: (depth key, index) pairs
+  // & room to permute the largest array through
+  uint64_t* sort_keys;
+  void*     sort_scratch;
 } r_batch;
 
+typedef struct {
+  /* batch - the CPU copy of the instance data (shader, sheet & arrays)
+   * vao - the vertex array with the quad & per instance attributes
+   * buffer - the GPU resident instance buffer */
+  r_batch  batch;
+  uint32_t vao, buffer;
+
+  /* dirty_start - the first instance that needs to be uploaded
+   * dirty_end - one past the last instance that needs to be uploaded */
+  uint32_t dirty_start, dirty_end;
+} r_static_batch;
+
 typedef struct {
   float   life, last;
   float   rotation;
@@ -401,6 +486,21 @@ struct r_particles {
   int8_t calculate, type, use_animator, use_spawner, alive;
 };
 
+typedef struct {
+  /* supported - if the driver supports multi draw indirect (GL 4.3+ or
+   *             ARB_multi_draw_indirect + ARB_base_instance)
+   * shader - the shader whose batches get submitted indirectly (0 = off) */
+  uint8_t  supported;
+  r_shader shader;
+
+  /* vao - the vertex array with the quad & per instance attributes
+   * instance_buffer - holds every batch's instance data for the frame
+   * command_buffer - holds the DrawElementsIndirectCommand list
+   * instance_capacity - the max amount of instances the buffer can hold */
+  uint32_t vao, instance_buffer, command_buffer;
+  uint32_t instance_capacity;
+} r_indirect;
+
 typedef struct r_ctx {
   /* window - the rendering context's window
    * camera - the rendering context's camera */
@@ -447,6 +547,9 @@ typedef struct r_ctx {
   uint8_t  batch_count, batch_capacity;
   uint32_t batch_size;
 
+  /* indirect - multi draw indirect state for batches (if supported) */
+  r_indirect indirect;
+
   /* input_ctx - a pointer to an input context for glfw callbacks */
   i_ctx* input_ctx;
 
@@ -477,6 +580,9 @@ r_window_params r_window_params_create(uint32_t width, uint32_t height,
  * params - the window parameters for the game window
  * use_fbo - to use a framebuffer to render to or not (post-processing)
  * batch_count - the number of batches to create for different draw types
+ *               NOTE: a sheet & shader takes 2 batches when it has both opaque
+ *                     & translucent sprites, if there's no batch left its
+ *                     opaque sprites go in its translucent batch instead
  * batch_size - the max amount of sprites to store in each given batch
  * anim_map_size - the amount of animations to allow to be cached / mapped
  * shader_map_size - the amount of shaders to allow to be cached / mapped */
@@ -502,9 +608,24 @@ void r_ctx_destroy(r_ctx* ctx);
  * Currently just camera_update */
 void r_ctx_update(r_ctx* ctx);
 
-/* Call for the context to draw it's contents */
+/* Call for the context to draw it's contents
+ * NOTE: batches using the indirect shader (if set) are uploaded together &
+ *       submitted with a multi draw call per sheet, the rest fall back to one
+ *       draw call per batch */
 void r_ctx_draw(r_ctx* ctx);
 
+/* Check if the context can submit batches with multi draw indirect
+ * returns: 1 = supported, 0 = not supported */
+uint8_t r_ctx_indirect_supported(r_ctx* ctx);
+
+/* Set the shader for batches to be submitted via multi draw indirect
+ * NOTE: the shader has to read instance data from vertex attributes & sample
+ *       the sheet bound to unit 0, see resources/shaders/indirect.vert
+ * ctx - the context to set the shader for
+ * shader - the shader to use (0 = disable)
+ * returns: 1 = success, 0 = fail (not supported) */
+uint8_t r_ctx_set_indirect(r_ctx* ctx, r_shader shader);
+
 /* Check if OpenGL has thrown an error */
 uint32_t r_check_error(void);
 
@@ -825,6 +946,31 @@ void r_anim_pause(r_anim_viewer* anim);
 /* Reset an animation's state & time */
 void r_anim_reset(r_anim_viewer* anim);
 
+/* Create a clock to share an animation's playback between sprites
+ * anim - the animation for the clock to step through
+ * returns: animation clock, anim = 0 on fail (i.e no frames) */
+r_anim_clock r_anim_clock_create(r_anim* anim);
+
+/* Advance a clock & its current frame
+ * clock - the clock to update
+ * delta - the time since last update (milliseconds) */
+void r_anim_clock_update(r_anim_clock* clock, time_s delta);
+
+/* Get the frame index of a clock offset by a phase
+ * clock - the clock to check
+ * phase - the time offset from the clock (milliseconds)
+ * returns: index into the animation's frames */
+uint32_t r_anim_clock_frame(r_anim_clock* clock, time_s phase);
+
+/* Set a clock's state to play */
+void r_anim_clock_play(r_anim_clock* clock);
+
+/* Set a clock's state to stopped */
+void r_anim_clock_stop(r_anim_clock* clock);
+
+/* Set a clock's state to paused */
+void r_anim_clock_pause(r_anim_clock* clock);
+
 /* Create a sprite to draw
  * shader - the shader program to draw it with
  * pos - the position of the sprite
@@ -872,6 +1018,14 @@ void r_sprite_get_pos(vec2 dst, r_sprite* sprite);
  * anim - the animation to set it to draw */
 void r_sprite_set_anim(r_sprite* sprite, r_anim* anim);
 
+/* Set a sprite to follow a shared animation clock
+ * NOTE: the sprite's frame & state come from the clock, so r_sprite_update
+ *       no longer has to advance the animation per sprite
+ * sprite - the sprite to affect
+ * clock - the clock to follow
+ * phase - the time offset from the clock (milliseconds) */
+void r_sprite_set_clock(r_sprite* sprite, r_anim_clock* clock, time_s phase);
+
 /* Set a sprite's texture
  * sprite - the sprite to affect
  * sheet - the texture sheet to use
@@ -891,13 +1045,14 @@ void r_sprite_set_color(r_sprite* sprite, vec4 color);
 
 /* Update a sprite for drawing
  * sprite - the sprite to update
- * delta - the time since last update / frame */
-void r_sprite_update(r_sprite* sprite, long delta);
+ * delta - the time since last update / frame (milliseconds) */
+void r_sprite_update(r_sprite* sprite, time_s delta);
 
 /* Call for a sprite to be drawn in the next batch
  * ctx - the context to draw the sprite in
- * sprite - the sprite to draw */
-void r_sprite_draw_batch(r_ctx* ctx, r_sprite* sprite);
+ * sprite - the sprite to draw
+ * returns: 1 = batched, 0 = hidden or no batch free for it */
+uint8_t r_sprite_draw_batch(r_ctx* ctx, r_sprite* sprite);
 
 /* Call for a sprite to be drawn
  * ctx - the context to draw the sprite in
@@ -911,6 +1066,95 @@ void r_sprite_draw(r_ctx* ctx, r_sprite* sprite);
  * returns: sprites drawn successfully */
 uint32_t r_sprites_draw(r_ctx* ctx, r_sprite* sprites, uint32_t sprite_count);
 
+/* Create a signed distance field font atlas from a TTF font
+ * NOTE: the atlas is single channel (sampled as white with the distance in
+ *       alpha), see resources/shaders/sdf.frag to render it
+ * data - the TTF file data
+ * length - the length of the data in bytes
+ * size - the pixel height to generate glyphs at
+ * first - the first codepoint to include (i.e 32 for ASCII)
+ * count - the number of codepoints to include (i.e 95 for ASCII)
+ * returns: font, sheet.id = 0 on fail */
+r_font r_font_create(unsigned char* data, uint32_t length, float size,
+                     uint32_t first, uint32_t count);
+
+/* Free a font's atlas & glyphs
+ * font - the font to destroy */
+void r_font_destroy(r_font* font);
+
+/* Draw UTF-8 text into the sprite batches
+ * NOTE: glyphs are drawn with the sprites in the next r_ctx_draw
+ * ctx - the context to draw in
+ * font - the font to draw with
+ * shader - the (batch) shader to draw with, any that maps a sprite's sub
+ *          texture coords (i.e resources/shaders/instanced.vert) with a
+ *          distance field fragment shader (see resources/shaders/sdf.frag)
+ * text - the text to draw
+ * position - the position of the start of the first baseline
+ * size - the height of the text in world units
+ * color - the color of the text
+ * layer - the layer of the text
+ * returns: the number of glyphs drawn */
+uint32_t r_text_draw(r_ctx* ctx, r_font* font, r_shader shader,
+                     const char* text, vec2 position, float size, vec4 color,
+                     uint8_t layer);
+
+/* Get the width of a line of text
+ * font - the font to measure with
+ * text - the text to measure
+ * size - the height of the text in world units
+ * returns: the width of the widest line in world units */
+float r_text_width(r_font* font, const char* text, float size);
+
+/* Create a static batch from sprites that rarely change (i.e backgrounds)
+ * NOTE: the sprites must share a sheet & shader, the shader has to read
+ *       instance data from vertex attributes, see resources/shaders/static.vert
+ * ctx - the context to create the batch with
+ * sprites - the sprites to build the batch from
+ * count - the number of sprites
+ * returns: static batch, vao = 0 on fail */
+r_static_batch r_static_batch_create(r_ctx* ctx, r_sprite* sprites,
+                                     uint32_t count);
+
+/* Update a range of a static batch from changed sprites
+ * batch - the batch to update
+ * sprites - the sprites to read from (sprites[0] = instance `start`)
+ * start - the first instance to update
+ * count - the number of instances to update */
+void r_static_batch_update(r_static_batch* batch, r_sprite* sprites,
+                           uint32_t start, uint32_t count);
+
+/* Override the color of an instance in a static batch
+ * batch - the batch to affect
+ * index - the index of the instance
+ * color - the color to set */
+void r_static_batch_set_color(r_static_batch* batch, uint32_t index,
+                              vec4 color);
+
+/* Override the flip of an instance in a static batch
+ * batch - the batch to affect
+ * index - the index of the instance
+ * flip_x - if to flip the instance on the X Axis
+ * flip_y - if to flip the instance on the Y Axis */
+void r_static_batch_set_flip(r_static_batch* batch, uint32_t index,
+                             uint8_t flip_x, uint8_t flip_y);
+
+/* Override the subtexture (i.e animation frame) of an instance
+ * batch - the batch to affect
+ * index - the index of the instance
+ * subtex - the subtexture ID in the batch's sheet */
+void r_static_batch_set_subtex(r_static_batch* batch, uint32_t index,
+                               uint32_t subtex);
+
+/* Draw a static batch, only uploading the instances changed since last draw
+ * ctx - the context to draw with
+ * batch - the batch to draw */
+void r_static_batch_draw(r_ctx* ctx, r_static_batch* batch);
+
+/* Free a static batch's buffers
+ * batch - the batch to destroy */
+void r_static_batch_destroy(r_static_batch* batch);
+
 /* Get the current state of a sprite's animation
  * sprite - the sprite to check
  * returns: 0 = STOPPED, 1 = PLAY, 2 = PAUSE */
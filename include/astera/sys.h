@@ -1,6 +1,5 @@
 // TODO:
 // - Multi iterator to parse duplicate keys
-// - Threading
 // - System Info
 
 /* MACROS:
@@ -139,6 +138,96 @@ s_timer s_timer_create();
    returns: time actually slept */
 time_s s_sleep(time_s duration);
 
+/* Thread entry point
+   data - the user data passed on creation
+   returns: exit code of the thread */
+typedef int32_t (*s_thread_func)(void* data);
+
+/* Opaque handles to OS threads & mutexes */
+typedef struct s_thread_t* s_thread;
+typedef struct s_mutex_t*  s_mutex;
+
+/* Start a new thread
+   func - the function to run on the thread
+   data - the user data to pass to func
+   returns: thread handle, 0 = fail */
+s_thread s_thread_create(s_thread_func func, void* data);
+
+/* Wait for a thread to finish & free its handle
+   thread - the thread to join
+   returns: the exit code of the thread function */
+int32_t s_thread_join(s_thread thread);
+
+/* Create a mutex
+   returns: mutex handle, 0 = fail */
+s_mutex s_mutex_create();
+
+/* Destroy a mutex (must be unlocked)
+   mutex - the mutex to destroy */
+void s_mutex_destroy(s_mutex mutex);
+
+/* Lock a mutex, blocking until it's available
+   mutex - the mutex to lock */
+void s_mutex_lock(s_mutex mutex);
+
+/* Unlock a mutex
+   mutex - the mutex to unlock */
+void s_mutex_unlock(s_mutex mutex);
+
+/* Opaque handle to a read only memory mapped file */
+typedef struct s_map_t* s_map;
+
+/* Map a whole file into memory (read only), pages are read in by the OS as
+   they're touched
+   path - the path of the file to map
+   returns: map handle, 0 = fail */
+s_map s_map_open(const char* path);
+
+/* Unmap a file & free its handle
+   map - the map to close */
+void s_map_close(s_map map);
+
+/* Get the start of a mapped file
+   map - the map to check
+   returns: pointer to the mapped file's first byte */
+const unsigned char* s_map_data(s_map map);
+
+/* Get the size of a mapped file
+   map - the map to check
+   returns: the size of the file in bytes */
+uint64_t s_map_size(s_map map);
+
+/* Hint to the OS that part of a mapping is going to be read soon
+   map - the map to hint
+   offset - the first byte to read in
+   length - the number of bytes to read in
+   NOTE: only a hint, a no-op where the OS has no way to take it */
+void s_map_prefetch(s_map map, uint64_t offset, uint64_t length);
+
+/* Atomically load a value (acquire)
+   ptr - the value to load
+   returns: the value */
+uint32_t s_atomic_load(volatile uint32_t* ptr);
+
+/* Atomically store a value (release)
+   ptr - the value to store to
+   value - the value to store */
+void s_atomic_store(volatile uint32_t* ptr, uint32_t value);
+
+/* Atomically add to a value
+   ptr - the value to add to
+   value - the amount to add
+   returns: the value before the add */
+uint32_t s_atomic_add(volatile uint32_t* ptr, uint32_t value);
+
+/* Atomically compare & swap a value
+   ptr - the value to swap
+   expected - the value ptr must hold for the swap to happen
+   desired - the value to swap in
+   returns: 1 = swapped, 0 = ptr didn't hold expected */
+uint8_t s_atomic_cas(volatile uint32_t* ptr, uint32_t expected,
+                     uint32_t desired);
+
 /* Convert integer to String
    value - the value to convert to string
    string - the storage for the string
@@ -23,6 +23,58 @@
 #include <stdio.h>
 #include <string.h>
 
+#if !defined(ASTERA_AUDIO_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define A_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define A_SIMD_NEON
+#endif
+#endif
+
+// AL_EXT_float32
+#if !defined(AL_FORMAT_MONO_FLOAT32)
+#define AL_FORMAT_MONO_FLOAT32   0x10010
+#define AL_FORMAT_STEREO_FLOAT32 0x10011
+#endif
+
+typedef void (*a_al_proc)(void);
+
+// ALC_SOFT_loopback
+#if !defined(ALC_SOFT_loopback)
+#define ALC_FORMAT_CHANNELS_SOFT 0x1990
+#define ALC_FORMAT_TYPE_SOFT     0x1991
+#define ALC_SHORT_SOFT           0x1402
+#define ALC_MONO_SOFT            0x1500
+#define ALC_STEREO_SOFT          0x1501
+#endif
+
+typedef ALCdevice* (*a_alc_loopback_open)(const ALCchar*);
+typedef ALCboolean (*a_alc_format_supported)(ALCdevice*, ALCsizei, ALCenum,
+                                             ALCenum);
+typedef void (*a_alc_render)(ALCdevice*, ALCvoid*, ALCsizei);
+
+// ALC_SOFT_device_clock & AL_SOFT_source_start_delay
+#if !defined(ALC_SOFT_device_clock)
+#define ALC_DEVICE_CLOCK_SOFT 0x1600
+#endif
+
+typedef void (*a_alc_get_int64)(ALCdevice*, ALCenum, ALCsizei, int64_t*);
+typedef void (*a_al_play_at)(ALuint, int64_t);
+
+// A set of buffers sfx pick between at random
+typedef struct {
+  /* name - the name of the group (0 = unused)
+   * bufs - the buffers picked between
+   * count - the number of buffers
+   * last - the index picked last, skipped on the next pick */
+  const char* name;
+  uint16_t    bufs[ASTERA_AUDIO_GROUP_SIZE];
+  uint16_t    count, last;
+} a_group;
+
 struct a_ctx {
   // context - the OpenAL-Soft Context
   // device - the device OpenAL-Soft is using
@@ -47,6 +99,21 @@ struct a_ctx {
   a_sfx*   sfx;
   uint16_t sfx_count, sfx_capacity;
 
+  // voice_free - the pool's OpenAL sources not held by an sfx
+  // voice_count - the number of sources in the pool
+  // voice_free_count - the number of sources in voice_free
+  // last_update - the time of the last update, for virtual sfx
+  uint32_t* voice_free;
+  uint16_t  voice_count, voice_free_count;
+  time_s    last_update;
+
+  // voice_batch - sources bound by a_sfx_play_many, started all at once
+  // voice_batch_count - the number of sources in voice_batch
+  // batching - if bound sources go into voice_batch instead of playing
+  uint32_t* voice_batch;
+  uint16_t  voice_batch_count;
+  uint8_t   batching;
+
   // buffers - the list of audio buffers (sounds / raw data)
   // buffer_names - a list of names for audio buffers in the list
   // buffer_count - the current amount of buffers in the list
@@ -73,12 +140,22 @@ struct a_ctx {
   uint8_t resizable; // allow for dynamic resizing of arrays
   uint8_t allow;     // allow playback
   uint8_t use_fx;    // allow effect usage
+  uint8_t soft_fx;   // run effects in software (no EFX)
+
+  // buf_rate - rate sfx buffers are converted to when created (0 = as is)
+  uint32_t buf_rate;
+
+  // groups - variation groups sfx pick their buffer from
+  // rng - xorshift state variations are picked with
+  // orphans - if a restore left sfx / songs waiting to be played again
+  a_group  groups[ASTERA_AUDIO_GROUPS];
+  uint32_t rng;
+  uint8_t  orphans;
 
-  // pcm - a buffer for decoding
-  // pcm_length - the number of shorts the pcm can hold
-  // pcm_index - the index of the last element in the pcm
-  uint16_t* pcm;
-  uint32_t  pcm_length, pcm_index;
+  // pcm_length - the max samples a song decodes per buffer
+  // float32 - if songs can upload float samples (AL_EXT_float32)
+  uint32_t pcm_length;
+  uint8_t  float32;
 
   // layers - array of layers used to manage playback
   // layer_count - the number of layers in the array currently
@@ -88,6 +165,71 @@ struct a_ctx {
 
   // error - the last error value set
   int32_t error;
+
+  // cmds - the ring of posted commands
+  // cmd_sequences - per slot sequence numbers for claiming / publishing
+  // cmd_write - the next position a producer will claim
+  // cmd_read - the next position a_ctx_update will run
+  a_cmd*             cmds;
+  volatile uint32_t* cmd_sequences;
+  volatile uint32_t  cmd_write;
+  uint32_t           cmd_read;
+
+  // defer_updates - AL_SOFT_deferred_updates' alDeferUpdatesSOFT (optional)
+  // process_updates - AL_SOFT_deferred_updates' alProcessUpdatesSOFT
+  a_al_proc defer_updates, process_updates;
+
+  // render - alcRenderSamplesSOFT for loopback contexts (0 = real device)
+  // render_rate - the sample rate loopback contexts render at
+  // render_clock - milliseconds rendered, loopback contexts' only clock
+  // render_channels - the channels loopback contexts render
+  // render_frames - sample frames rendered
+  a_alc_render render;
+  uint32_t     render_rate, render_channels;
+  time_s       render_clock;
+  uint64_t     render_frames;
+
+  // device_clock - ALC_SOFT_device_clock's alcGetInteger64vSOFT (optional)
+  // play_at - AL_SOFT_source_start_delay's alSourcePlayAtTimeSOFT (optional)
+  // mix_rate - the device's output rate
+  // clock_start - when the context was created, for devices with no clock
+  a_alc_get_int64 device_clock;
+  a_al_play_at    play_at;
+  uint32_t        mix_rate;
+  time_s          clock_start;
+
+  // stream - the song streaming thread (0 = songs decode in a_ctx_update)
+  // stream_lock - guards song state shared with the streaming thread
+  // stream_run - cleared to ask the streaming thread to exit
+  // stream_interval - milliseconds between streaming thread refills
+  s_thread          stream;
+  s_mutex           stream_lock;
+  volatile uint32_t stream_run;
+  time_s            stream_interval;
+
+  // decoder - the thread decoding OGG buffers (started on first use)
+  // decode_run - cleared to ask the decode thread to exit
+  // pcm_cache - directory decoded PCM is saved to (optional)
+  // pcm_budget - max bytes of decoded PCM to keep in OpenAL buffers
+  // pcm_bytes - bytes of decoded PCM currently in OpenAL buffers
+  // buf_clock - counts buffer plays, stamped on buffers for eviction
+  s_thread          decoder;
+  volatile uint32_t decode_run;
+  const char*       pcm_cache;
+  uint32_t          pcm_budget, pcm_bytes, buf_clock;
+
+  // stats - the counters as of the last update
+  // decode_time - milliseconds spent decoding songs since the last update
+  // decode_samples - song samples decoded since the last update
+  // underruns - song queues run dry since the context was created
+  // last_underrun - when a song's queue last ran dry
+  // last_underrun_song - the song whose queue last ran dry
+  // al_calls - OpenAL source calls made since the last update
+  // dsp_time - milliseconds spent on software effects since the last update
+  a_stats  stats;
+  time_s   decode_time, dsp_time, last_underrun;
+  uint32_t decode_samples, underruns, al_calls;
+  uint16_t last_underrun_song;
 };
 
 #if !defined(ASTERA_AL_NO_FX)
@@ -121,6 +263,21 @@ static LPALGETAUXILIARYEFFECTSLOTI    alGetAuxiliaryEffectSloti;
 static LPALGETAUXILIARYEFFECTSLOTIV   alGetAuxiliaryEffectSlotiv;
 static LPALGETAUXILIARYEFFECTSLOTF    alGetAuxiliaryEffectSlotf;
 static LPALGETAUXILIARYEFFECTSLOTFV   alGetAuxiliaryEffectSlotfv;
+#else
+// EFX's reverb defaults, for the software reverb when there's no efx.h
+#define AL_REVERB_DEFAULT_DENSITY               1.f
+#define AL_REVERB_DEFAULT_DIFFUSION             1.f
+#define AL_REVERB_DEFAULT_GAIN                  0.32f
+#define AL_REVERB_DEFAULT_GAINHF                0.89f
+#define AL_REVERB_DEFAULT_DECAY_TIME            1.49f
+#define AL_REVERB_DEFAULT_DECAY_HFRATIO         0.83f
+#define AL_REVERB_DEFAULT_REFLECTIONS_GAIN      0.05f
+#define AL_REVERB_DEFAULT_REFLECTIONS_DELAY     0.007f
+#define AL_REVERB_DEFAULT_LATE_REVERB_GAIN      1.26f
+#define AL_REVERB_DEFAULT_LATE_REVERB_DELAY     0.011f
+#define AL_REVERB_DEFAULT_AIR_ABSORPTION_GAINHF 0.994f
+#define AL_REVERB_DEFAULT_ROOM_ROLLOFF_FACTOR   0.f
+#define AL_REVERB_DEFAULT_DECAY_HFLIMIT         1
 #endif
 
 static inline float _a_clamp(float value, float min, float max, float def) {
@@ -145,126 +302,93 @@ static inline float _a_clamp(float value, float min, float max, float def) {
 } */
 
 static a_layer* _a_get_layer(a_ctx* ctx, uint16_t layer_id) {
+  if (layer_id == 0 || layer_id > ctx->layer_capacity) {
+    return 0;
+  }
+
   return (ctx->layers[layer_id - 1].id == 0) ? 0 : &ctx->layers[layer_id - 1];
 }
 
-static uint8_t _a_layer_add(a_layer* layer, uint32_t id, uint8_t is_sfx) {
-  if (is_sfx) {
-    if (layer->sfx_count == layer->sfx_capacity - 1) {
-      ASTERA_FUNC_DBG("no free sfx slots in layer\n");
-      return 0;
-    }
+static a_layer_link* _a_get_link(a_ctx* ctx, uint16_t id, uint8_t is_sfx) {
+  return (is_sfx) ? &ctx->sfx[id - 1].link : &ctx->songs[id - 1].link;
+}
 
-    for (uint16_t i = 0; i < layer->sfx_capacity; ++i) {
-      if (layer->sfx[i] == id) {
-        ASTERA_FUNC_DBG("sfx id already in layer\n");
-        return 0;
-      }
+static uint8_t _a_layer_remove(a_ctx* ctx, uint16_t id, uint8_t is_sfx) {
+  a_layer_link* link = _a_get_link(ctx, id, is_sfx);
 
-      if (layer->sfx[i] == 0) {
-        layer->sfx[i] = id;
-        ++layer->sfx_count;
-        return 1;
-      }
-    }
+  if (!link->layer) {
+    return 0;
+  }
+
+  a_layer*  layer = &ctx->layers[link->layer - 1];
+  uint16_t* head  = (is_sfx) ? &layer->sfx_head : &layer->song_head;
+
+  if (link->prev) {
+    _a_get_link(ctx, link->prev, is_sfx)->next = link->next;
   } else {
-    if (layer->song_count == layer->song_capacity - 1) {
-      ASTERA_FUNC_DBG("no free song slots in layer\n");
-      return 0;
-    }
+    *head = link->next;
+  }
 
-    for (uint16_t i = 0; i < layer->song_capacity; ++i) {
-      if (layer->songs[i] == id) {
-        ASTERA_FUNC_DBG("song already in layer\n");
-        return 0;
-      }
+  if (link->next) {
+    _a_get_link(ctx, link->next, is_sfx)->prev = link->prev;
+  }
 
-      if (layer->songs[i] == 0) {
-        layer->songs[i] = id;
-        ++layer->song_count;
-        return 1;
-      }
-    }
+  if (is_sfx) {
+    --layer->sfx_count;
+  } else {
+    --layer->song_count;
   }
 
-  return 0;
+  *link = (a_layer_link){0};
+
+  return 1;
 }
 
-static uint8_t _a_layer_remove(a_layer* layer, uint32_t id, uint8_t is_sfx) {
-  if (!layer) {
+// Moves the resource out of any layer it's already in
+static uint8_t _a_layer_add(a_ctx* ctx, a_layer* layer, uint16_t id,
+                            uint8_t is_sfx) {
+  a_layer_link* link = _a_get_link(ctx, id, is_sfx);
+
+  if (link->layer == layer->id) {
+    ASTERA_FUNC_DBG("%s already in layer\n", (is_sfx) ? "sfx" : "song");
     return 0;
   }
 
-  uint8_t start = 0;
-  if (is_sfx) {
-    if (layer->sfx_count == 0) {
-      return 0;
-    }
+  uint32_t count    = (is_sfx) ? layer->sfx_count : layer->song_count;
+  uint32_t capacity = (is_sfx) ? layer->sfx_capacity : layer->song_capacity;
 
-    for (uint16_t i = 0; i < layer->sfx_capacity - 1; ++i) {
-      if (layer->sfx[i] == id) {
-        start = 1;
-      }
+  if (count >= capacity) {
+    ASTERA_FUNC_DBG("no free %s slots in layer\n", (is_sfx) ? "sfx" : "song");
+    return 0;
+  }
 
-      if (start) {
-        layer->sfx[i] = layer->sfx[i + 1];
-      }
-    }
+  _a_layer_remove(ctx, id, is_sfx);
 
-    if (start) {
-      layer->sfx[layer->sfx_count] = 0;
-      --layer->sfx_count;
-      return 1;
-    }
-  } else {
-    if (layer->song_count == 0)
-      return 0;
+  uint16_t* head = (is_sfx) ? &layer->sfx_head : &layer->song_head;
 
-    for (uint16_t i = 0; i < layer->song_capacity - 1; ++i) {
-      if (layer->songs[i] == id) {
-        start = 1;
-      }
+  link->layer = layer->id;
+  link->prev  = 0;
+  link->next  = *head;
 
-      if (start) {
-        layer->songs[i] = layer->songs[i + 1];
-      }
-    }
+  if (*head) {
+    _a_get_link(ctx, *head, is_sfx)->prev = id;
+  }
 
-    if (start) {
-      layer->songs[layer->song_count] = 0;
-      --layer->song_count;
-      return 1;
-    }
+  *head = id;
+
+  if (is_sfx) {
+    ++layer->sfx_count;
+  } else {
+    ++layer->song_count;
   }
 
-  return 0;
+  return 1;
 }
 
 // Get the gain of the containing layer for a resource
-static float _a_get_layered_gain(a_ctx* ctx, uint32_t id, uint8_t is_sfx) {
-  for (uint16_t i = 0; i < ctx->layer_capacity; ++i) {
-    a_layer* layer = &ctx->layers[i];
-
-    if (layer->id) {
-      if (is_sfx && layer->sfx_count > 0) {
-        for (uint32_t j = 0; j < layer->sfx_count; ++j) {
-          if (layer->sfx[j] == id) {
-            return layer->gain;
-          }
-        }
-      } else if (!is_sfx && layer->song_capacity > 0) {
-        for (uint32_t j = 0; j < layer->song_count; ++j) {
-          if (layer->songs[j] == id) {
-            return layer->gain;
-          }
-        }
-      } else {
-        continue;
-      }
-    }
-  }
-
-  return -1.f;
+static float _a_get_layered_gain(a_ctx* ctx, uint16_t id, uint8_t is_sfx) {
+  a_layer_link* link = _a_get_link(ctx, id, is_sfx);
+  return (link->layer) ? ctx->layers[link->layer - 1].gain : -1.f;
 }
 
 static float _a_get_gain(a_ctx* ctx, uint32_t id, uint8_t is_sfx) {
@@ -274,7 +398,7 @@ static float _a_get_gain(a_ctx* ctx, uint32_t id, uint8_t is_sfx) {
   if (is_sfx) {
     a_sfx* sfx = &ctx->sfx[id - 1];
     if (sfx->req) {
-      gain = sfx->req->gain;
+      gain = sfx->req->gain * sfx->gain_scale;
     } else {
       return -1.f;
     }
@@ -290,719 +414,4129 @@ static float _a_get_gain(a_ctx* ctx, uint32_t id, uint8_t is_sfx) {
   return (lgain != -1.f) ? lgain * gain : gain;
 }
 
-static void _a_layer_destroy(a_layer* layer) {
+static void _a_layer_destroy(a_ctx* ctx, a_layer* layer) {
   if (!layer)
     return;
 
+  while (layer->sfx_head) {
+    _a_layer_remove(ctx, layer->sfx_head, 1);
+  }
+
+  while (layer->song_head) {
+    _a_layer_remove(ctx, layer->song_head, 0);
+  }
+
   layer->id            = 0;
   layer->name          = 0;
   layer->song_count    = 0;
   layer->song_capacity = 0;
   layer->sfx_count     = 0;
   layer->sfx_capacity  = 0;
-
-  if (layer->sfx)
-    free(layer->sfx);
-
-  if (layer->songs)
-    free(layer->songs);
 }
 
-static uint8_t _a_song_reset(a_ctx* ctx, a_song* song) {
-  song->delta         = 0.f;
-  song->curr          = 0.f;
-  song->sample_offset = 0;
-  song->curr          = 0;
-
-  stb_vorbis_seek_start(song->vorbis);
+// Inverse distance attenuation from the listener
+static float _a_attenuation(a_ctx* ctx, vec3 position) {
+  vec3 diff;
+  vec3_sub(diff, position, ctx->listener.position);
 
-  // uint32_t error = stb_vorbis_get_error(song->vorbis);
+  float distance = vec3_len(diff);
 
-  // Unqueue anything existing
-  alSourceStop(song->source);
-  alSourceUnqueueBuffers(song->source, song->buffer_count, song->buffers);
+  if (distance <= 1.f) {
+    return 1.f;
+  }
 
-  for (uint8_t i = 0; i < song->buffer_count; ++i) {
-    uint32_t buffer = song->buffers[i];
-    float    buf_time =
-        (float)((float)song->buffer_sizes[0] / song->info.sample_rate) * 1000.f;
-    song->curr += buf_time;
+  return 1.f / (1.f + ASTERA_AL_ROLLOFF_FACTOR * (distance - 1.f));
+}
 
-    memset(ctx->pcm, 0, ctx->pcm_length * sizeof(uint16_t));
-    uint32_t pcm_total_length = 0;
+// Distance from the listener as a fraction of range (0 = unlimited range)
+static float _a_range_ratio(a_ctx* ctx, vec3 position, float range) {
+  if (range <= 0.f) {
+    return 0.f;
+  }
 
-    for (uint16_t p = 0; p < song->packets_per_buffer; ++p) {
-      uint32_t pcm_remaining = ctx->pcm_length - pcm_total_length;
+  vec3 diff;
+  vec3_sub(diff, position, ctx->listener.position);
 
-      if (pcm_remaining < song->info.max_frame_size) {
-        break;
-      }
+  return vec3_len(diff) / range;
+}
 
-      if (pcm_remaining == 0) {
-        break;
-      }
+// Cull / LOD an sfx by its range, with a margin so it doesn't flicker at
+// the edges
+// returns: 1 = the sfx's LOD changed, 0 = no change
+static uint8_t _a_sfx_cull(a_ctx* ctx, a_sfx* sfx) {
+  float ratio  = _a_range_ratio(ctx, sfx->req->position, sfx->req->range);
+  float margin = 1.f + ASTERA_AUDIO_CULL_MARGIN;
 
-      uint32_t num_samples = stb_vorbis_get_samples_short_interleaved(
-          song->vorbis, song->channels, ctx->pcm + pcm_total_length,
-          pcm_remaining);
+  if (sfx->culled) {
+    sfx->culled = ratio > 1.f;
+  } else {
+    sfx->culled = ratio > margin;
+  }
 
-      if (num_samples > 0) {
-        int32_t sample_count = song->channels * num_samples;
-        pcm_total_length += sample_count;
-      }
+  // Only long running (looping) sfx are worth moving between LODs
+  uint8_t lod = sfx->lod;
+  if (!sfx->req->loop) {
+    sfx->lod = 0;
+  } else if (sfx->lod) {
+    sfx->lod = ratio > ASTERA_AUDIO_LOD_DISTANCE;
+  } else {
+    sfx->lod = ratio > ASTERA_AUDIO_LOD_DISTANCE * margin;
+  }
 
-      for (uint8_t i = 0; i < song->buffer_count - 1; ++i) {
-        song->buffer_sizes[i] = song->buffer_sizes[i + 1];
-      }
+  return lod != sfx->lod;
+}
 
-      song->buffer_sizes[song->buffer_count - 1] = num_samples;
-    }
+static float _a_sfx_audibility(a_ctx* ctx, a_sfx* sfx) {
+  if (sfx->paused || sfx->culled) {
+    return 0.f;
+  }
 
-    stb_vorbis_info info = stb_vorbis_get_info(song->vorbis);
+  float gain = _a_get_gain(ctx, sfx->id, 1);
 
-    alBufferData(buffer, song->format, ctx->pcm,
-                 pcm_total_length * sizeof(uint16_t), info.sample_rate);
-    alSourceQueueBuffers(song->source, 1, &buffer);
+  if (gain <= 0.f) {
+    return 0.f;
   }
 
-  return 1;
+  return gain * _a_attenuation(ctx, sfx->req->position);
 }
 
-void a_efx_info(a_ctx* ctx) {
-  if (alcIsExtensionPresent(ctx->device, "ALC_EXT_EFX") == AL_FALSE) {
-    ASTERA_FUNC_DBG("No ALC_EXT_EFX.\n");
-  } else {
-    ASTERA_FUNC_DBG("ALC_EXT_EFX Present.\n");
+// If a is less important than b, b's audibility is divided by ratio
+static uint8_t _a_sfx_less(a_sfx* a, a_sfx* b, float ratio) {
+  if (a->req->priority != b->req->priority) {
+    return a->req->priority < b->req->priority;
   }
 
-  uint32_t s_sends = 0;
-#if !defined(ASTERA_AL_NO_FX) && defined(ALC_MAX_AUXILIARY_SENDS)
-  s_sends = ALC_MAX_AUXILIARY_SENDS;
-#endif
-  ASTERA_FUNC_DBG("MAX_AUXILIARY_SENDS: %i\n", s_sends);
+  return a->audibility * ratio < b->audibility;
 }
 
-const char* a_ctx_get_device(a_ctx* ctx, uint8_t* string_length) {
-  const ALchar* name;
+// lod - skip the effect sends, only applying filters
+static void _a_source_fx(a_ctx* ctx, uint32_t source, a_req* req,
+                         uint8_t lod) {
+#if !defined(ASTERA_AL_NO_FX)
+  if (!ctx->use_fx) {
+    return;
+  }
 
-  if (ctx->device) {
-    name = alcGetString(ctx->device, ALC_DEVICE_SPECIFIER);
-  } else {
-    name = alcGetString(0, ALC_DEFAULT_DEVICE_SPECIFIER);
+  // Clear out anything left from the last sfx to use this source
+  for (uint16_t i = 0; i < ctx->fx_per_source; ++i) {
+    alSource3i(source, AL_AUXILIARY_SEND_FILTER, AL_EFFECTSLOT_NULL, i,
+               AL_FILTER_NULL);
   }
+  alSourcei(source, AL_DIRECT_FILTER, AL_FILTER_NULL);
 
-  uint8_t length = strlen(name);
+  ctx->al_calls += ctx->fx_per_source + 1;
 
-  if (string_length) {
-    *string_length = length;
+  // Apply fx
+  for (uint16_t i = 0; !lod && i < req->fx_count; ++i) {
+    // Make sure it's valid within the range of filters
+    if (req->fx[i] <= ctx->fx_capacity && req->fx[i] > 0) {
+      alSource3i(source, AL_AUXILIARY_SEND_FILTER,
+                 (ALint)ctx->fx_slots[req->fx[i] - 1].slot_id, i, 0);
+      ++ctx->al_calls;
+    }
   }
 
-  return name;
+  // Apply filters
+  for (uint16_t i = 0; i < req->filter_count; ++i) {
+    if (req->filters[i] <= ctx->filter_capacity && req->filters[i] > 0) {
+      alSourcei(source, AL_DIRECT_FILTER,
+                ctx->filter_slots[req->filters[i] - 1].al_id);
+      ++ctx->al_calls;
+    }
+  }
+#else
+  (void)ctx;
+  (void)source;
+  (void)req;
+  (void)lod;
+#endif
 }
 
-uint8_t a_can_play(a_ctx* ctx) { return ctx->allow; }
-
-a_ctx* a_ctx_create(const char* device, uint8_t layers, uint16_t max_sfx,
-                    uint16_t max_buffers, uint16_t max_songs, uint16_t max_fx,
-                    uint16_t max_filters, uint32_t pcm_size) {
-  a_ctx* ctx = (a_ctx*)calloc(1, sizeof(a_ctx));
+static uint8_t _a_vec3_eq(vec3 a, vec3 b) {
+  return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
 
-  if (!ctx) {
-    ASTERA_FUNC_DBG("unable to malloc initial space for context.\n");
-    return 0;
+// Send only the request values that changed since they were last sent
+// returns: the number of OpenAL calls made
+static uint32_t _a_source_push(uint32_t source, a_source_cache* sent,
+                               a_req* req, float gain, float pitch,
+                               uint8_t set_loop) {
+  uint32_t calls = 0;
+
+  if (!sent->valid || sent->gain != gain) {
+    alSourcef(source, AL_GAIN, gain);
+    sent->gain = gain;
+    ++calls;
   }
 
-  ALCdevice* al_device = alcOpenDevice(device);
+  if (!sent->valid || sent->pitch != pitch) {
+    alSourcef(source, AL_PITCH, pitch);
+    sent->pitch = pitch;
+    ++calls;
+  }
 
-#if !defined(ASTERA_AL_NO_FX)
-  if (alcIsExtensionPresent(al_device, "ALC_EXT_EFX") == AL_FALSE) {
-    ctx->use_fx = 0;
-  } else {
-    ctx->use_fx = 1;
+  if (!sent->valid || !_a_vec3_eq(sent->position, req->position)) {
+    alSource3f(source, AL_POSITION, req->position[0], req->position[1],
+               req->position[2]);
+    vec3_dup(sent->position, req->position);
+    ++calls;
   }
 
-  // Disable effects if we're not using any of them
-  if (!max_fx && !max_filters) {
-    ctx->use_fx = 0;
+  if (!sent->valid || !_a_vec3_eq(sent->velocity, req->velocity)) {
+    alSource3f(source, AL_VELOCITY, req->velocity[0], req->velocity[1],
+               req->velocity[2]);
+    vec3_dup(sent->velocity, req->velocity);
+    ++calls;
   }
-#else
-  ctx->use_fx = 0;
-#endif
 
-  int attribs[4] = {0};
+  if (!sent->valid || sent->range != req->range) {
+    alSourcef(source, AL_MAX_DISTANCE, req->range);
+    sent->range = req->range;
+    ++calls;
+  }
 
-#if !defined(ASTERA_AL_NO_FX) && defined(ALC_MAX_AUXILIARY_SENDS)
-  if (ctx->use_fx) {
-    attribs[0] = ALC_MAX_AUXILIARY_SENDS;
-    attribs[1] = 4;
+  if (set_loop && (!sent->valid || sent->loop != req->loop)) {
+    alSourcei(source, AL_LOOPING, req->loop);
+    sent->loop = req->loop;
+    ++calls;
   }
-#endif
 
-  ALCcontext* context = alcCreateContext(al_device, attribs);
+  sent->valid = 1;
 
-  if (!alcMakeContextCurrent(context)) {
-    ASTERA_FUNC_DBG("Error creating OpenAL Context\n");
-    free(ctx);
-    return 0;
-  }
+  return calls;
+}
 
-  ctx->context = context;
-  ctx->device  = al_device;
+// Apply the request's dynamic values to an sfx's source
+static void _a_sfx_apply(a_ctx* ctx, a_sfx* sfx) {
+  ctx->al_calls += _a_source_push(sfx->source, &sfx->sent, sfx->req,
+                                  _a_get_gain(ctx, sfx->id, 1), sfx->pitch, 1);
+}
 
-#if defined(ASTERA_AL_DISTANCE_MODEL)
-  alDistanceModel(ASTERA_AL_DISTANCE_MODEL);
-#endif
+// Convert float samples to 16 bit, clamping anything past [-1, 1]
+static void _a_float_to_s16(const float* src, int16_t* dst, uint32_t count) {
+  uint32_t i = 0;
 
-#if !defined(ASTERA_AL_NO_FX)
-  if (ctx->use_fx) {
-    ALint fx_per_source;
-    alcGetIntegerv(al_device, ALC_MAX_AUXILIARY_SENDS, 1, &fx_per_source);
-    ctx->fx_per_source = (uint16_t)fx_per_source;
+#if defined(A_SIMD_SSE2)
+  __m128 scale = _mm_set1_ps(32767.f);
+  __m128 max   = _mm_set1_ps(1.f);
+  __m128 min   = _mm_set1_ps(-1.f);
 
-    if (!ctx->fx_per_source) {
-      ASTERA_FUNC_DBG("0 effects allowed per source, disabling effects.\n");
-      ctx->use_fx = 0;
-    }
+  for (; i + 8 <= count; i += 8) {
+    __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), min), max);
+    __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), min), max);
+
+    __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(a, scale));
+    __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(b, scale));
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(lo, hi));
   }
+#elif defined(A_SIMD_NEON)
+  float32x4_t scale = vdupq_n_f32(32767.f);
+  float32x4_t max   = vdupq_n_f32(1.f);
+  float32x4_t min   = vdupq_n_f32(-1.f);
+
+  for (; i + 8 <= count; i += 8) {
+    float32x4_t a = vminq_f32(vmaxq_f32(vld1q_f32(src + i), min), max);
+    float32x4_t b = vminq_f32(vmaxq_f32(vld1q_f32(src + i + 4), min), max);
+
+    int32x4_t lo = vcvtq_s32_f32(vmulq_f32(a, scale));
+    int32x4_t hi = vcvtq_s32_f32(vmulq_f32(b, scale));
+    vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+  }
+#endif
 
-  if (ctx->use_fx) {
-#define LOAD_PROC(T, x) ((x) = (T)alGetProcAddress(#x))
-    LOAD_PROC(LPALGENEFFECTS, alGenEffects);
-    LOAD_PROC(LPALGENFILTERS, alGenFilters);
-    LOAD_PROC(LPALDELETEEFFECTS, alDeleteEffects);
-    LOAD_PROC(LPALDELETEFILTERS, alDeleteFilters);
-    LOAD_PROC(LPALISEFFECT, alIsEffect);
-    LOAD_PROC(LPALEFFECTI, alEffecti);
-    LOAD_PROC(LPALEFFECTIV, alEffectiv);
-    LOAD_PROC(LPALEFFECTF, alEffectf);
-    LOAD_PROC(LPALEFFECTFV, alEffectfv);
-    LOAD_PROC(LPALGETEFFECTI, alGetEffecti);
-    LOAD_PROC(LPALGETEFFECTIV, alGetEffectiv);
-    LOAD_PROC(LPALGETEFFECTF, alGetEffectf);
-    LOAD_PROC(LPALGETEFFECTFV, alGetEffectfv);
+  for (; i < count; ++i) {
+    float v = src[i];
+    v       = (v > 1.f) ? 1.f : (v < -1.f) ? -1.f : v;
+    dst[i]  = (int16_t)(v * 32767.f);
+  }
+}
 
-    LOAD_PROC(LPALFILTERF, alFilterf);
-    LOAD_PROC(LPALFILTERI, alFilteri);
+#define A_PI 3.14159265358979f
 
-    LOAD_PROC(LPALGENAUXILIARYEFFECTSLOTS, alGenAuxiliaryEffectSlots);
-    LOAD_PROC(LPALDELETEAUXILIARYEFFECTSLOTS, alDeleteAuxiliaryEffectSlots);
-    LOAD_PROC(LPALISAUXILIARYEFFECTSLOT, alIsAuxiliaryEffectSlot);
-    LOAD_PROC(LPALAUXILIARYEFFECTSLOTI, alAuxiliaryEffectSloti);
-    LOAD_PROC(LPALAUXILIARYEFFECTSLOTIV, alAuxiliaryEffectSlotiv);
+// Kaiser window shape, ~80dB of stopband for the resampler
+#define A_RESAMPLE_BETA 8.0
+// Fraction of the lower Nyquist frequency the resampler passes
+#define A_RESAMPLE_ROLLOFF 0.9
 
-    LOAD_PROC(LPALAUXILIARYEFFECTSLOTF, alAuxiliaryEffectSlotf);
-    LOAD_PROC(LPALAUXILIARYEFFECTSLOTFV, alAuxiliaryEffectSlotfv);
-    LOAD_PROC(LPALGETAUXILIARYEFFECTSLOTI, alGetAuxiliaryEffectSloti);
-    LOAD_PROC(LPALGETAUXILIARYEFFECTSLOTIV, alGetAuxiliaryEffectSlotiv);
-    LOAD_PROC(LPALGETAUXILIARYEFFECTSLOTF, alGetAuxiliaryEffectSlotf);
-    LOAD_PROC(LPALGETAUXILIARYEFFECTSLOTFV, alGetAuxiliaryEffectSlotfv);
+// Zeroth order modified Bessel function, for the Kaiser window
+static double _a_bessel_i0(double x) {
+  double sum = 1.0, term = 1.0;
 
-#undef LOAD_PROC
+  for (uint32_t k = 1; k < 64 && term > 1e-12 * sum; ++k) {
+    double half = x / (2.0 * k);
+    term *= half * half;
+    sum += term;
+  }
+
+  return sum;
+}
 
-    ctx->fx_capacity = max_fx;
-    ctx->fx_count    = 0;
+static uint32_t _a_gcd(uint32_t a, uint32_t b) {
+  while (b) {
+    uint32_t t = a % b;
+    a          = b;
+    b          = t;
+  }
 
-    if (max_fx) {
-      ctx->fx_slots = (a_fx*)calloc(ctx->fx_capacity, sizeof(a_fx));
+  return a;
+}
 
-      if (!ctx->fx_slots) {
-        ASTERA_FUNC_DBG("unable to allocate %i fx slots\n", ctx->fx_capacity);
+// Sum of a * b, count is a multiple of 4
+static float _a_dot(const float* a, const float* b, uint32_t count) {
+#if defined(A_SIMD_SSE2)
+  __m128 acc = _mm_setzero_ps();
 
-        alcDestroyContext(ctx->context);
-        alcCloseDevice(ctx->device);
+  for (uint32_t i = 0; i < count; i += 4) {
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
 
-        free(ctx);
-        return 0;
-      }
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+  return _mm_cvtss_f32(acc);
+#elif defined(A_SIMD_NEON)
+  float32x4_t acc = vdupq_n_f32(0.f);
 
-      for (uint16_t i = 0; i < ctx->fx_capacity; ++i) {
-        ctx->fx_slots[i].id = i + 1;
-      }
-    } else {
-      ctx->fx_slots = 0;
-    }
+  for (uint32_t i = 0; i < count; i += 4) {
+    acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+  }
 
-    ctx->filter_count    = 0;
-    ctx->filter_capacity = max_filters;
+  float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#else
+  float acc[4] = {0.f};
 
-    if (max_filters) {
-      ctx->filter_slots =
-          (a_filter*)calloc(ctx->filter_capacity, sizeof(a_filter));
+  for (uint32_t i = 0; i < count; i += 4) {
+    acc[0] += a[i] * b[i];
+    acc[1] += a[i + 1] * b[i + 1];
+    acc[2] += a[i + 2] * b[i + 2];
+    acc[3] += a[i + 3] * b[i + 3];
+  }
 
-      if (!ctx->filter_slots) {
-        ASTERA_FUNC_DBG("unable to allocate %i fx slots\n", ctx->fx_capacity);
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+}
 
-        alcDestroyContext(ctx->context);
-        alcCloseDevice(ctx->device);
+// Build a polyphase bank of Kaiser windowed sinc filters, phases * taps long
+// Each phase's taps line up with the input window starting taps / 2 - 1
+// samples before the sample the output falls after
+static float* _a_resample_bank(uint32_t phases, uint32_t taps, double cutoff) {
+  float* bank = (float*)malloc(sizeof(float) * phases * taps);
+  if (!bank) {
+    return 0;
+  }
 
-        free(ctx->fx_slots);
-        free(ctx);
+  double half = taps / 2.0;
+  double norm = _a_bessel_i0(A_RESAMPLE_BETA);
 
-        return 0;
-      }
+  for (uint32_t p = 0; p < phases; ++p) {
+    float* phase = &bank[p * taps];
+    double sum   = 0.0;
 
-      for (uint16_t i = 0; i < max_filters; ++i) {
-        ctx->filter_slots[i].id = i + 1;
-      }
-    } else {
-      ctx->filter_slots = 0;
+    for (uint32_t k = 0; k < taps; ++k) {
+      double x = (double)k - (half - 1.0) - (double)p / phases;
+      double r = x / half;
+      double w = (r * r < 1.0)
+                     ? _a_bessel_i0(A_RESAMPLE_BETA * sqrt(1.0 - r * r)) / norm
+                     : 0.0;
+      double t = 2.0 * cutoff * x;
+      double h = (x == 0.0) ? 1.0 : sin(A_PI * t) / (A_PI * t);
+
+      phase[k] = (float)(h * w);
+      sum += phase[k];
     }
-  }
-#endif
 
-  ctx->pcm_length = pcm_size;
-  ctx->pcm_index  = 0;
-  if (pcm_size) {
-    ctx->pcm = (uint16_t*)calloc(pcm_size, sizeof(uint16_t));
+    // Unity gain at DC for every phase, so there's no ripple between them
+    for (uint32_t k = 0; k < taps; ++k) {
+      phase[k] = (float)(phase[k] / sum);
+    }
   }
 
+  return bank;
+}
+
+// Resample 8 / 16 bit interleaved PCM to 16 bit at another rate
+// returns: the resampled PCM (malloc'd), 0 = unable to allocate
+static int16_t* _a_resample(const void* src, uint8_t bits, uint32_t frames,
+                            uint16_t channels, uint32_t src_rate,
+                            uint32_t dst_rate, uint32_t* out_frames) {
+  uint32_t gcd    = _a_gcd(src_rate, dst_rate);
+  uint32_t phases = dst_rate / gcd;
+  uint32_t ratio  = (src_rate + dst_rate - 1) / dst_rate;
+
+  // Rates without a small common step are snapped to the nearest phase
+  if (phases > ASTERA_AUDIO_RESAMPLE_PHASES) {
+    phases = ASTERA_AUDIO_RESAMPLE_PHASES;
+  }
+
+  // Downsampling narrows the filter, so widen it to keep the same slope
+  uint32_t taps = ((ASTERA_AUDIO_RESAMPLE_TAPS * ratio) + 3) & ~3u;
+  double   cutoff =
+      0.5 * A_RESAMPLE_ROLLOFF *
+      ((dst_rate < src_rate) ? (double)dst_rate / src_rate : 1.0);
+
+  uint32_t length = (uint32_t)(((uint64_t)frames * dst_rate + src_rate - 1) /
+                               src_rate);
+  uint32_t stride = frames + taps + 1;
+
+  float*   bank   = _a_resample_bank(phases, taps, cutoff);
+  float*   planar = (float*)calloc((size_t)stride * channels, sizeof(float));
+  float*   mixed  = (float*)malloc(sizeof(float) * length * channels);
+  int16_t* dst    = (int16_t*)malloc(sizeof(int16_t) * length * channels);
+
+  if (!bank || !planar || !mixed || !dst) {
+    free(bank);
+    free(planar);
+    free(mixed);
+    free(dst);
+    return 0;
+  }
+
+  // Split the channels out, padded with silence on both ends
+  for (uint16_t c = 0; c < channels; ++c) {
+    float* lane = &planar[c * stride + taps / 2 - 1];
+
+    if (bits == 8) {
+      const uint8_t* in = (const uint8_t*)src + c;
+      for (uint32_t i = 0; i < frames; ++i) {
+        lane[i] = ((int32_t)in[i * channels] - 128) / 128.f;
+      }
+    } else {
+      const int16_t* in = (const int16_t*)src + c;
+      for (uint32_t i = 0; i < frames; ++i) {
+        lane[i] = in[i * channels] / 32768.f;
+      }
+    }
+  }
+
+  for (uint32_t n = 0; n < length; ++n) {
+    uint64_t     pos    = (uint64_t)n * src_rate * phases / dst_rate;
+    uint32_t     index  = (uint32_t)(pos / phases);
+    const float* filter = &bank[(pos % phases) * taps];
+
+    for (uint16_t c = 0; c < channels; ++c) {
+      mixed[n * channels + c] =
+          _a_dot(&planar[c * stride + index], filter, taps);
+    }
+  }
+
+  _a_float_to_s16(mixed, dst, length * channels);
+
+  free(bank);
+  free(planar);
+  free(mixed);
+
+  *out_frames = length;
+  return dst;
+}
+
+static int16_t _a_load_int16(const unsigned char* data, int offset) {
+  return (int16_t)(data[offset] | (data[offset + 1] << 8));
+}
+
+static int32_t _a_load_int32(const unsigned char* data, int offset) {
+  return (int32_t)((uint32_t)data[offset] | ((uint32_t)data[offset + 1] << 8) |
+                   ((uint32_t)data[offset + 2] << 16) |
+                   ((uint32_t)data[offset + 3] << 24));
+}
+
+// Read bytes of a WAV file from its memory or its file
+// returns: the number of bytes read
+static uint32_t _a_wav_fetch(a_wav* wav, uint32_t offset, void* dst,
+                             uint32_t size) {
+  if (offset >= wav->size) {
+    return 0;
+  }
+
+  if (size > wav->size - offset) {
+    size = wav->size - offset;
+  }
+
+  if (!wav->file) {
+    memcpy(dst, wav->data + wav->base + offset, size);
+    return size;
+  }
+
+  FILE* file = (FILE*)wav->file;
+  if (fseek(file, (long)(wav->base + offset), SEEK_SET) != 0) {
+    return 0;
+  }
+
+  return (uint32_t)fread(dst, 1, size, file);
+}
+
+// Walk a WAV file's RIFF chunks for its format & where its PCM is
+// returns: 1 = success, 0 = fail (not a WAV file or unsupported format)
+static uint8_t _a_wav_parse(a_wav* wav, uint16_t* channels,
+                            uint32_t* sample_rate) {
+  unsigned char header[16];
+
+  if (_a_wav_fetch(wav, 0, header, 12) != 12 ||
+      memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+    ASTERA_FUNC_DBG("not a RIFF WAVE file.\n");
+    return 0;
+  }
+
+  uint8_t  has_fmt = 0;
+  uint32_t offset  = 12;
+
+  while (offset + 8 <= wav->size) {
+    if (_a_wav_fetch(wav, offset, header, 8) != 8) {
+      break;
+    }
+
+    uint32_t size = (uint32_t)_a_load_int32(header, 4);
+
+    if (memcmp(header, "fmt ", 4) == 0) {
+      if (size < 16 || _a_wav_fetch(wav, offset + 8, header, 16) != 16) {
+        ASTERA_FUNC_DBG("truncated WAV fmt chunk.\n");
+        return 0;
+      }
+
+      // 1 = PCM, 0xFFFE = extensible (assumed to hold PCM)
+      uint16_t format = (uint16_t)_a_load_int16(header, 0);
+      if (format != 1 && format != 0xFFFE) {
+        ASTERA_FUNC_DBG("unsupported WAV format %i.\n", format);
+        return 0;
+      }
+
+      *channels    = (uint16_t)_a_load_int16(header, 2);
+      *sample_rate = (uint32_t)_a_load_int32(header, 4);
+      wav->bits    = (uint16_t)_a_load_int16(header, 14);
+      has_fmt      = 1;
+    } else if (memcmp(header, "data", 4) == 0) {
+      if (!has_fmt) {
+        ASTERA_FUNC_DBG("WAV data chunk before its fmt chunk.\n");
+        return 0;
+      }
+
+      wav->pcm_offset = offset + 8;
+      wav->pcm_length = (size > wav->size - wav->pcm_offset)
+                            ? wav->size - wav->pcm_offset
+                            : size;
+      wav->read       = 0;
+
+      if ((wav->bits != 8 && wav->bits != 16) || *channels < 1 ||
+          *channels > 2 || !*sample_rate) {
+        ASTERA_FUNC_DBG("unsupported WAV: %i bit, %i channels.\n", wav->bits,
+                        *channels);
+        return 0;
+      }
+
+      return 1;
+    }
+
+    // Chunks are padded to an even size
+    offset += 8 + size + (size & 1);
+  }
+
+  ASTERA_FUNC_DBG("no data chunk in WAV file.\n");
+  return 0;
+}
+
+// Header of a decoded OGG file in the PCM cache directory
+typedef struct {
+  uint32_t magic, checksum, ogg_length;
+  uint32_t channels, sample_rate, frames;
+} a_pcm_header;
+
+// "APCM" little endian, marks files written by the PCM cache
+#define A_PCM_MAGIC 0x4D435041
+
+static uint32_t _a_fnv1a(const unsigned char* data, uint32_t length) {
+  uint32_t hash = 2166136261u;
+
+  for (uint32_t i = 0; i < length; ++i) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static void _a_pcm_cache_path(char* dst, uint32_t size, const char* directory,
+                              a_buf* buf) {
+  snprintf(dst, size, "%s/%08x%08x.pcm", directory, buf->checksum,
+           buf->ogg_length);
+}
+
+static int16_t* _a_pcm_cache_load(const char* directory, a_buf* buf) {
+  char path[512];
+  _a_pcm_cache_path(path, sizeof(path), directory, buf);
+
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    return 0;
+  }
+
+  a_pcm_header header;
+  int16_t*     pcm = 0;
+
+  if (fread(&header, sizeof(a_pcm_header), 1, file) == 1 &&
+      header.magic == A_PCM_MAGIC && header.checksum == buf->checksum &&
+      header.ogg_length == buf->ogg_length &&
+      header.channels == buf->channels &&
+      header.sample_rate == buf->sample_rate && header.frames == buf->length) {
+    size_t count = (size_t)header.frames * header.channels;
+    pcm          = (int16_t*)malloc(sizeof(int16_t) * count);
+
+    // A short read is a file cut off mid write, decode it again instead
+    if (pcm && fread(pcm, sizeof(int16_t), count, file) != count) {
+      free(pcm);
+      pcm = 0;
+    }
+  }
+
+  fclose(file);
+  return pcm;
+}
+
+static void _a_pcm_cache_save(const char* directory, a_buf* buf,
+                              int16_t* pcm) {
+  char path[512];
+  _a_pcm_cache_path(path, sizeof(path), directory, buf);
+
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    ASTERA_FUNC_DBG("unable to open %s for writing.\n", path);
+    return;
+  }
+
+  a_pcm_header header = {A_PCM_MAGIC,      buf->checksum,
+                         buf->ogg_length,  buf->channels,
+                         buf->sample_rate, buf->length};
+  size_t       count  = (size_t)buf->length * buf->channels;
+
+  fwrite(&header, sizeof(a_pcm_header), 1, file);
+  fwrite(pcm, sizeof(int16_t), count, file);
+  fclose(file);
+}
+
+// Decode an OGG buffer's samples, from the PCM cache if it has them
+// NOTE: runs on the decode thread, so no OpenAL calls
+static int16_t* _a_buf_decode(const char* directory, a_buf* buf) {
+  int16_t* pcm = (directory) ? _a_pcm_cache_load(directory, buf) : 0;
+  if (pcm) {
+    return pcm;
+  }
+
+  int32_t channels, sample_rate;
+  int32_t frames = stb_vorbis_decode_memory(buf->ogg, buf->ogg_length,
+                                            &channels, &sample_rate,
+                                            (short**)&pcm);
+
+  if (frames <= 0 || !pcm) {
+    free(pcm);
+    return 0;
+  }
+
+  // Buffers created with resampling on are told their converted rate
+  if ((uint32_t)sample_rate != buf->sample_rate) {
+    uint32_t resampled = 0;
+    int16_t* converted =
+        _a_resample(pcm, 16, (uint32_t)frames, buf->channels,
+                    (uint32_t)sample_rate, buf->sample_rate, &resampled);
+    free(pcm);
+
+    if (!converted) {
+      return 0;
+    }
+
+    pcm    = converted;
+    frames = (int32_t)resampled;
+  }
+
+  // The length from the header is what sfx were told, so match it
+  if ((uint32_t)frames != buf->length) {
+    size_t   count   = (size_t)buf->length * buf->channels;
+    int16_t* resized = (int16_t*)realloc(pcm, sizeof(int16_t) * count);
+
+    if (!resized) {
+      free(pcm);
+      return 0;
+    }
+
+    pcm = resized;
+    if ((uint32_t)frames < buf->length) {
+      memset(&pcm[frames * buf->channels], 0,
+             sizeof(int16_t) * (count - frames * buf->channels));
+    }
+  }
+
+  if (directory) {
+    _a_pcm_cache_save(directory, buf, pcm);
+  }
+
+  return pcm;
+}
+
+// Read an OGG buffer's header for its format, the OGG is decoded later
+// returns: 1 = success, 0 = fail
+static uint8_t _a_buf_ogg_info(a_ctx* ctx, a_buf* buf,
+                               const unsigned char* data, uint32_t length) {
+  int32_t     error;
+  stb_vorbis* vorbis = stb_vorbis_open_memory(data, length, &error, 0);
+
+  if (!vorbis) {
+    ASTERA_FUNC_DBG("unable to open vorbis header, vorbis error %i\n", error);
+    return 0;
+  }
+
+  stb_vorbis_info info = stb_vorbis_get_info(vorbis);
+
+  buf->length      = stb_vorbis_stream_length_in_samples(vorbis);
+  buf->sample_rate = info.sample_rate;
+  buf->channels    = info.channels;
+
+  stb_vorbis_close(vorbis);
+
+  // The conversion itself happens when it's decoded
+  if (ctx->buf_rate && buf->sample_rate != ctx->buf_rate) {
+    buf->length = (uint32_t)(((uint64_t)buf->length * ctx->buf_rate +
+                              buf->sample_rate - 1) /
+                             buf->sample_rate);
+    buf->sample_rate = ctx->buf_rate;
+  }
+
+  return 1;
+}
+
+// Copy a pak entry out, reading it from disk for file paks
+// NOTE: runs on the decode thread, so no OpenAL calls
+static unsigned char* _a_pak_read(pak_t* pak, uint32_t index,
+                                  uint32_t* length) {
+  uint32_t       size = pak_size(pak, index);
+  unsigned char* data = (unsigned char*)malloc(size);
+
+  if (!data || !size) {
+    free(data);
+    return 0;
+  }
+
+  if (pak->is_mem) {
+    memcpy(data, pak->data.ptr + pak_offset(pak, index), size);
+  } else {
+    FILE* file = fopen(pak->data.filepath, "rb");
+
+    if (!file || fseek(file, (long)pak_offset(pak, index), SEEK_SET) != 0 ||
+        fread(data, 1, size, file) != size) {
+      ASTERA_FUNC_DBG("unable to read %s from %s\n", pak_name(pak, index),
+                      pak->data.filepath);
+      free(data);
+      data = 0;
+    }
+
+    if (file) {
+      fclose(file);
+    }
+  }
+
+  *length = size;
+  return data;
+}
+
+// Extract, decode & resample a preloaded buffer, leaving it to be uploaded
+// returns: the PCM to upload, 0 = fail
+// NOTE: runs on the decode thread, so no OpenAL calls
+static int16_t* _a_buf_load(a_ctx* ctx, a_buf* buf) {
+  uint32_t       length = 0;
+  unsigned char* data   = _a_pak_read(buf->pak, buf->pak_index, &length);
+
+  buf->pak = 0;
+
+  if (!data) {
+    return 0;
+  }
+
+  // OGG buffers keep the file to decode from again if they're evicted
+  if (length >= 4 && memcmp(data, "OggS", 4) == 0) {
+    if (!_a_buf_ogg_info(ctx, buf, data, length)) {
+      free(data);
+      return 0;
+    }
+
+    buf->ogg        = data;
+    buf->ogg_length = length;
+    buf->checksum   = _a_fnv1a(data, length);
+
+    return _a_buf_decode(ctx->pcm_cache, buf);
+  }
+
+  a_wav    wav         = {0};
+  uint16_t channels    = 0;
+  uint32_t sample_rate = 0;
+  int16_t* pcm         = 0;
+
+  wav.data = data;
+  wav.size = length;
+
+  if (_a_wav_parse(&wav, &channels, &sample_rate)) {
+    const unsigned char* src    = &data[wav.pcm_offset];
+    uint32_t             frames = wav.pcm_length / (wav.bits / 8) / channels;
+    uint32_t             count  = frames * channels;
+
+    buf->channels    = channels;
+    buf->sample_rate = sample_rate;
+    buf->length      = frames;
+
+    // Uploads are always 16 bit, so 8 bit files get widened here
+    if (ctx->buf_rate && sample_rate != ctx->buf_rate) {
+      pcm = _a_resample(src, wav.bits, frames, channels, sample_rate,
+                        ctx->buf_rate, &buf->length);
+      buf->sample_rate = ctx->buf_rate;
+    } else if ((pcm = (int16_t*)malloc(sizeof(int16_t) * count))) {
+      for (uint32_t i = 0; i < count; ++i) {
+        pcm[i] = (wav.bits == 8) ? (int16_t)((src[i] - 128) << 8)
+                                 : _a_load_int16(src, i * 2);
+      }
+    }
+  }
+
+  free(data);
+  return pcm;
+}
+
+static int32_t _a_decode_thread(void* data) {
+  a_ctx* ctx = (a_ctx*)data;
+
+  while (s_atomic_load(&ctx->decode_run)) {
+    uint8_t idle = 1;
+
+    for (uint16_t i = 0; i < ctx->buffer_capacity; ++i) {
+      a_buf* buf = &ctx->buffers[i];
+
+      if (s_atomic_cas(&buf->state, A_BUF_QUEUED, A_BUF_DECODING)) {
+        buf->pcm = _a_buf_decode(ctx->pcm_cache, buf);
+      } else if (s_atomic_cas(&buf->state, A_BUF_LOADING, A_BUF_DECODING)) {
+        buf->pcm = _a_buf_load(ctx, buf);
+      } else {
+        continue;
+      }
+
+      s_atomic_store(&buf->state, (buf->pcm) ? A_BUF_DECODED : A_BUF_FAILED);
+      idle = 0;
+    }
+
+    if (idle) {
+      s_sleep(ASTERA_AUDIO_STREAM_INTERVAL);
+    }
+  }
+
+  return 0;
+}
+
+// Drop the least recently played OGG buffers until bytes more fit the budget
+static void _a_buf_evict(a_ctx* ctx, uint32_t bytes) {
+  while (ctx->pcm_bytes && ctx->pcm_bytes + bytes > ctx->pcm_budget) {
+    a_buf* lru = 0;
+
+    for (uint16_t i = 0; i < ctx->buffer_high; ++i) {
+      a_buf* buf = &ctx->buffers[i];
+
+      if (buf->ogg && buf->bytes && !buf->users &&
+          (!lru || buf->last_use < lru->last_use)) {
+        lru = buf;
+      }
+    }
+
+    if (!lru) {
+      return;
+    }
+
+    // OpenAL only lets go of a buffer's data when the buffer is deleted
+    alDeleteBuffers(1, &lru->buf);
+    alGenBuffers(1, &lru->buf);
+
+    ctx->pcm_bytes -= lru->bytes;
+    lru->bytes = 0;
+    s_atomic_store(&lru->state, A_BUF_EMPTY);
+  }
+}
+
+static void _a_buf_upload(a_ctx* ctx, a_buf* buf) {
+  uint32_t bytes  = buf->length * buf->channels * sizeof(int16_t);
+  int32_t  format = (buf->channels > 1) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+
+  // Only OGG buffers can be decoded again, so only they count to the budget
+  if (buf->ogg) {
+    _a_buf_evict(ctx, bytes);
+  }
+
+  alBufferData(buf->buf, format, buf->pcm, bytes, buf->sample_rate);
+
+  free(buf->pcm);
+  buf->pcm   = 0;
+  buf->bytes = (buf->ogg) ? bytes : 0;
+  ctx->pcm_bytes += buf->bytes;
+
+  s_atomic_store(&buf->state, A_BUF_READY);
+}
+
+// Find an open buffer slot, the one past the high water mark if none under it
+static a_buf* _a_buf_slot(a_ctx* ctx) {
+  if (ctx->buffer_count == ctx->buffer_capacity) {
+    return 0;
+  }
+
+  for (uint16_t i = 0; i < ctx->buffer_high; ++i) {
+    if (ctx->buffers[i].buf == 0) {
+      return &ctx->buffers[i];
+    }
+  }
+
+  return (ctx->buffer_high < ctx->buffer_capacity)
+             ? &ctx->buffers[ctx->buffer_high]
+             : 0;
+}
+
+// Start the decode thread if it isn't running yet
+// returns: 1 = buffers can be queued for it, 0 = decode in place
+static uint8_t _a_decode_start(a_ctx* ctx) {
+  if (!ctx->render && !ctx->decoder) {
+    s_atomic_store(&ctx->decode_run, 1);
+    ctx->decoder = s_thread_create(_a_decode_thread, ctx);
+
+    if (!ctx->decoder) {
+      ASTERA_FUNC_DBG("unable to start decode thread.\n");
+    }
+  }
+
+  return !ctx->render && ctx->decoder;
+}
+
+// Get an OGG buffer on its way to being playable
+static void _a_buf_request(a_ctx* ctx, a_buf* buf) {
+  uint32_t state = s_atomic_load(&buf->state);
+
+  if (state == A_BUF_DECODED) {
+    _a_buf_upload(ctx, buf);
+    return;
+  }
+
+  if (state != A_BUF_EMPTY) {
+    return;
+  }
+
+  // Loopback contexts decode in place so renders don't depend on timing
+  if (!_a_decode_start(ctx)) {
+    buf->pcm = _a_buf_decode(ctx->pcm_cache, buf);
+
+    if (buf->pcm) {
+      _a_buf_upload(ctx, buf);
+    } else {
+      s_atomic_store(&buf->state, A_BUF_FAILED);
+    }
+    return;
+  }
+
+  s_atomic_store(&buf->state, A_BUF_QUEUED);
+}
+
+// Take a buffer back from the decode thread, waiting out a decode in progress
+static void _a_buf_settle(a_buf* buf) {
+  if (s_atomic_cas(&buf->state, A_BUF_QUEUED, A_BUF_EMPTY) ||
+      s_atomic_cas(&buf->state, A_BUF_LOADING, A_BUF_EMPTY)) {
+    return;
+  }
+
+  while (s_atomic_load(&buf->state) == A_BUF_DECODING) {
+    s_sleep(1);
+  }
+}
+
+static uint8_t _a_buf_ready(a_ctx* ctx, a_sfx* sfx) {
+  return s_atomic_load(&ctx->buffers[sfx->buffer - 1].state) == A_BUF_READY;
+}
+
+// Hold a source back to start with the rest of a batch
+static void _a_voice_batch_add(a_ctx* ctx, uint32_t source) {
+  // A voice stolen within the batch is already in it
+  for (uint16_t i = 0; i < ctx->voice_batch_count; ++i) {
+    if (ctx->voice_batch[i] == source) {
+      return;
+    }
+  }
+
+  if (ctx->voice_batch_count < ctx->voice_count) {
+    ctx->voice_batch[ctx->voice_batch_count++] = source;
+  }
+}
+
+// Give an sfx a voice from the pool & pick up from its (virtual) time
+static void _a_sfx_bind(a_ctx* ctx, a_sfx* sfx) {
+  uint32_t source = ctx->voice_free[--ctx->voice_free_count];
+  a_buf*   buf    = &ctx->buffers[sfx->buffer - 1];
+
+  alSourcei(source, AL_BUFFER, buf->buf);
+  _a_source_fx(ctx, source, sfx->req, sfx->lod);
+
+  sfx->source     = source;
+  sfx->sent.valid = 0;
+  _a_sfx_apply(ctx, sfx);
+
+  alSourcef(source, AL_SEC_OFFSET, (float)sfx->req->time);
+  ctx->al_calls += 2;
+
+  // Scheduled sfx are started on their sample by _a_sfx_schedule
+  if (!sfx->paused && !sfx->scheduled) {
+    if (ctx->batching) {
+      _a_voice_batch_add(ctx, source);
+    } else {
+      alSourcePlay(source);
+      ++ctx->al_calls;
+    }
+  }
+}
+
+// Take an sfx's voice back into the pool, leaving the sfx virtual
+static void _a_sfx_unbind(a_ctx* ctx, a_sfx* sfx) {
+  if (sfx->req) {
+    float sec_offset;
+    alGetSourcef(sfx->source, AL_SEC_OFFSET, &sec_offset);
+    sfx->req->time = sec_offset;
+  }
+
+  alSourceStop(sfx->source);
+  alSourcei(sfx->source, AL_BUFFER, 0);
+  ctx->al_calls += 3;
+
+  ctx->voice_free[ctx->voice_free_count++] = sfx->source;
+  sfx->source                              = 0;
+}
+
+static void _a_sfx_release(a_ctx* ctx, a_sfx* sfx) {
+  if (sfx->source) {
+    _a_sfx_unbind(ctx, sfx);
+  }
+
+  _a_layer_remove(ctx, sfx->id, 1);
+
+  if (sfx->req) {
+    sfx->req->valid = 0;
+    sfx->req->state = AL_STOPPED;
+  }
+
+  --ctx->buffers[sfx->buffer - 1].users;
+
+  sfx->req        = 0;
+  sfx->buffer     = 0;
+  sfx->length     = 0;
+  sfx->paused     = 0;
+  sfx->scheduled  = 0;
+  sfx->start_song = 0;
+  sfx->audibility = 0.f;
+  sfx->culled     = 0;
+  sfx->lod        = 0;
+  sfx->orphan     = 0;
+
+  --ctx->sfx_count;
+}
+
+// The least important sfx currently holding a voice
+static a_sfx* _a_voice_worst(a_ctx* ctx) {
+  a_sfx* worst = 0;
+
+  for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+    a_sfx* sfx = &ctx->sfx[i];
+    if (sfx->source && sfx->req && (!worst || _a_sfx_less(sfx, worst, 1.f))) {
+      worst = sfx;
+    }
+  }
+
+  return worst;
+}
+
+// Hand voices to the most important audible virtual sfx
+static void _a_voice_balance(a_ctx* ctx) {
+  for (uint16_t n = 0; n < ctx->voice_count; ++n) {
+    a_sfx* best = 0;
+
+    for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+      a_sfx* sfx = &ctx->sfx[i];
+
+      if (!sfx->buffer || !sfx->req || sfx->source || sfx->scheduled ||
+          sfx->audibility < ASTERA_AUDIO_MIN_AUDIBILITY ||
+          !_a_buf_ready(ctx, sfx)) {
+        continue;
+      }
+
+      if (!best || _a_sfx_less(best, sfx, 1.f)) {
+        best = sfx;
+      }
+    }
+
+    if (!best) {
+      return;
+    }
+
+    if (!ctx->voice_free_count) {
+      a_sfx* worst = _a_voice_worst(ctx);
+
+      // Only steal with some margin so voices don't flip back & forth
+      if (!worst || !_a_sfx_less(worst, best, ASTERA_AUDIO_STEAL_RATIO)) {
+        return;
+      }
+
+      _a_sfx_unbind(ctx, worst);
+    }
+
+    _a_sfx_bind(ctx, best);
+  }
+}
+
+// Give a new sfx a voice if it's audible & it matters more than some other
+static void _a_sfx_claim(a_ctx* ctx, a_sfx* sfx) {
+  if (sfx->audibility < ASTERA_AUDIO_MIN_AUDIBILITY ||
+      !_a_buf_ready(ctx, sfx)) {
+    return;
+  }
+
+  if (!ctx->voice_free_count) {
+    a_sfx* worst = _a_voice_worst(ctx);
+    if (worst && _a_sfx_less(worst, sfx, 1.f)) {
+      _a_sfx_unbind(ctx, worst);
+    }
+  }
+
+  if (ctx->voice_free_count) {
+    _a_sfx_bind(ctx, sfx);
+  }
+}
+
+static uint64_t _a_ns_to_sample(int64_t ns, uint32_t rate) {
+  return (uint64_t)(ns / 1000000000) * rate +
+         (uint64_t)(ns % 1000000000) * rate / 1000000000;
+}
+
+static int64_t _a_sample_to_ns(uint64_t sample, uint32_t rate) {
+  return (int64_t)(sample / rate) * 1000000000 +
+         (int64_t)((sample % rate) * 1000000000 / rate);
+}
+
+// Move a song scheduled sfx's start to match where the song is
+// returns: 1 = ready to schedule, 0 = held back or dropped with the song
+static uint8_t _a_sfx_follow(a_ctx* ctx, a_sfx* sfx, uint64_t now) {
+  a_song* song = &ctx->songs[sfx->start_song - 1];
+
+  if (ctx->stream_lock) {
+    s_mutex_lock(ctx->stream_lock);
+  }
+
+  // Go by what the song was asked to do, a source that's starved for a
+  // moment reads as stopped too
+  uint8_t held    = song->req && (song->paused || song->starting);
+  uint8_t dropped = !held && (!song->req || !song->playing);
+  double  ahead   = (sfx->start_time - song->delta) / MS_TO_SEC;
+
+  if (ctx->stream_lock) {
+    s_mutex_unlock(ctx->stream_lock);
+  }
+
+  if (dropped) {
+    _a_sfx_release(ctx, sfx);
+    return 0;
+  }
+
+  // Paused (or still priming) songs hold their sfx back with them
+  if (held) {
+    return 0;
+  }
+
+  ahead *= ctx->mix_rate;
+  if (ahead >= 0.0) {
+    sfx->start = now + (uint64_t)ahead;
+  } else {
+    sfx->start = now - (uint64_t)fmin(-ahead, (double)now);
+  }
+
+  return 1;
+}
+
+// If a song scheduled sfx's start is stale, its song having stopped moving
+static uint8_t _a_sfx_held(a_ctx* ctx, a_sfx* sfx) {
+  if (!sfx->start_song) {
+    return 0;
+  }
+
+  a_song* song = &ctx->songs[sfx->start_song - 1];
+  return !song->req || !song->playing || song->paused || song->starting;
+}
+
+// Start a scheduled sfx once it's close enough to land on its sample
+static void _a_sfx_schedule(a_ctx* ctx, a_sfx* sfx, uint64_t now) {
+  int64_t ahead = (int64_t)(sfx->start - now);
+  int64_t lead  = (int64_t)ASTERA_AUDIO_SCHEDULE_LEAD * ctx->mix_rate / 1000;
+
+  // Without a way to start in the future, wait for the sample to pass
+  uint8_t exact = ctx->play_at && !ctx->render;
+  if (ahead > lead || (ahead > 0 && !exact)) {
+    return;
+  }
+
+  // Late starts skip ahead to stay in time
+  sfx->req->time  = (ahead < 0) ? (time_s)-ahead / ctx->mix_rate : 0;
+  sfx->req->state = AL_PLAYING;
+  sfx->audibility = _a_sfx_audibility(ctx, sfx);
+
+  _a_sfx_claim(ctx, sfx);
+
+  if (sfx->source && !sfx->paused) {
+    if (ahead > 0) {
+      ctx->play_at(sfx->source, _a_sample_to_ns(sfx->start, ctx->mix_rate));
+    } else {
+      alSourcePlay(sfx->source);
+    }
+  }
+
+  sfx->scheduled = 0;
+}
+
+static void _a_song_ring_clear(a_song* song) {
+  s_atomic_store(&song->ring_head, 0);
+  s_atomic_store(&song->ring_tail, 0);
+  song->decoded = 0;
+}
+
+// Read PCM out of a WAV file as float
+// returns: the number of frames read
+static int32_t _a_wav_read(a_wav* wav, uint16_t channels, float* dst,
+                           uint32_t samples) {
+  uint32_t sample_bytes = wav->bits / 8;
+  uint32_t frame_bytes  = sample_bytes * channels;
+  uint32_t done         = 0;
+
+  while (done < samples) {
+    uint32_t bytes = (samples - done) * sample_bytes;
+
+    if (bytes > ASTERA_AUDIO_WAV_READ) {
+      bytes = ASTERA_AUDIO_WAV_READ;
+    }
+
+    if (bytes > wav->pcm_length - wav->read) {
+      bytes = wav->pcm_length - wav->read;
+    }
+
+    bytes -= bytes % frame_bytes;
+    bytes = _a_wav_fetch(wav, wav->pcm_offset + wav->read, wav->raw, bytes);
+    bytes -= bytes % frame_bytes;
+
+    if (!bytes) {
+      break;
+    }
+
+    wav->read += bytes;
+
+    uint32_t count = bytes / sample_bytes;
+    float*   out   = dst + done;
+
+    if (wav->bits == 16) {
+      for (uint32_t i = 0; i < count; ++i) {
+        out[i] = _a_load_int16(wav->raw, i * 2) / 32768.f;
+      }
+    } else {
+      for (uint32_t i = 0; i < count; ++i) {
+        out[i] = (wav->raw[i] - 128) / 128.f;
+      }
+    }
+
+    done += count;
+  }
+
+  return (int32_t)(done / channels);
+}
+
+// Software effects, run on a song's PCM before it's uploaded when there's no
+// EFX. Filters & EQ are biquads, reverb is a 4 line feedback delay network
+
+// EFX's reference frequencies for its filters' LF & HF gains
+#define A_FILTER_LF_REFERENCE 250.f
+#define A_FILTER_HF_REFERENCE 5000.f
+
+// The lowest gain a shelf or peak is built with (-60dB), a gain of 0 would
+// zero every coefficient & mute the whole band rather than just the shelf
+#define A_FILTER_MIN_GAIN 0.001f
+
+// The longest reflections + late reverb delay in seconds
+#define A_FDN_MAX_DELAY 0.4f
+
+typedef struct {
+  float b0, b1, b2, a1, a2;
+  float z1[2], z2[2];
+} a_biquad;
+
+// Base lengths of the delay lines in seconds, spread so their echoes don't
+// line up
+static const float a_fdn_lengths[4] = {0.0297f, 0.0371f, 0.0411f, 0.0437f};
+
+typedef struct {
+  // pre - the delay ahead of the reflections & the lines (mono)
+  // lines - the network's delay lines, sized for a density of 1
+  float*   pre;
+  float*   lines[4];
+  uint32_t pre_length, pre_pos, refl_tap, late_tap;
+  uint32_t lengths[4], pos[4];
+
+  // feedback - each line's gain per pass, from the decay time
+  // lp - each line's damping filter state
+  float feedback[4], lp[4];
+  float damp, diffusion, refl_gain, wet;
+} a_fdn;
+
+struct a_dsp_t {
+  uint32_t rate;
+  uint16_t channels;
+
+  // reverb / eq / filter - the slots in use (0 = none)
+  // *_made - the slot's values the coefficients were last made from
+  a_fx*       reverb;
+  a_fx_reverb reverb_made;
+  a_fx*       eq;
+  a_fx_eq     eq_made;
+  a_filter*   filter;
+  a_filter    filter_made;
+
+  a_fdn    fdn;
+  a_biquad bands[4];
+  a_biquad shelves[2];
+  uint8_t  shelf_count;
+  float    filter_gain;
+
+  // wet - the reverb's output, mixed back in after the filter
+  // time - milliseconds spent running the chain
+  float* wet;
+  time_s time;
+};
+
+static void _a_biquad_set(a_biquad* bq, float b0, float b1, float b2,
+                          float a0, float a1, float a2) {
+  bq->b0 = b0 / a0;
+  bq->b1 = b1 / a0;
+  bq->b2 = b2 / a0;
+  bq->a1 = a1 / a0;
+  bq->a2 = a2 / a0;
+}
+
+// A shelf (slope of 1) from the RBJ cookbook
+// high - 1 = high shelf, 0 = low shelf
+// gain - the linear gain past the shelf's frequency
+static void _a_biquad_shelf(a_biquad* bq, uint8_t high, float freq,
+                            float gain, uint32_t rate) {
+  if (freq > rate * 0.45f) {
+    freq = rate * 0.45f;
+  }
+
+  float a     = sqrtf(fmaxf(gain, A_FILTER_MIN_GAIN));
+  float w0    = 2.f * A_PI * freq / rate;
+  float c     = cosf(w0);
+  float alpha = sinf(w0) / 2.f * sqrtf(2.f);
+  float k     = 2.f * sqrtf(a) * alpha;
+
+  if (high) {
+    _a_biquad_set(bq, a * ((a + 1) + (a - 1) * c + k),
+                  -2 * a * ((a - 1) + (a + 1) * c),
+                  a * ((a + 1) + (a - 1) * c - k), (a + 1) - (a - 1) * c + k,
+                  2 * ((a - 1) - (a + 1) * c), (a + 1) - (a - 1) * c - k);
+  } else {
+    _a_biquad_set(bq, a * ((a + 1) - (a - 1) * c + k),
+                  2 * a * ((a - 1) - (a + 1) * c),
+                  a * ((a + 1) - (a - 1) * c - k), (a + 1) + (a - 1) * c + k,
+                  -2 * ((a - 1) + (a + 1) * c), (a + 1) + (a - 1) * c - k);
+  }
+}
+
+// A peak from the RBJ cookbook
+// width - the width of the peak in octaves
+static void _a_biquad_peak(a_biquad* bq, float freq, float gain, float width,
+                           uint32_t rate) {
+  if (freq > rate * 0.45f) {
+    freq = rate * 0.45f;
+  }
+
+  float a     = sqrtf(fmaxf(gain, A_FILTER_MIN_GAIN));
+  float w0    = 2.f * A_PI * freq / rate;
+  float s     = sinf(w0);
+  float c     = cosf(w0);
+  float alpha = s * sinhf(logf(2.f) / 2.f * width * w0 / s);
+
+  _a_biquad_set(bq, 1 + alpha * a, -2 * c, 1 - alpha * a, 1 + alpha / a,
+                -2 * c, 1 - alpha / a);
+}
+
+// Run a biquad over interleaved PCM, a channel at a time
+static void _a_biquad_run(a_biquad* bq, float* pcm, uint32_t frames,
+                          uint16_t channels) {
+  for (uint16_t ch = 0; ch < channels; ++ch) {
+    float z1 = bq->z1[ch], z2 = bq->z2[ch];
+
+    for (uint32_t i = 0; i < frames; ++i) {
+      float x = pcm[i * channels + ch];
+      float y = bq->b0 * x + z1;
+
+      z1 = bq->b1 * x - bq->a1 * y + z2;
+      z2 = bq->b2 * x - bq->a2 * y;
+
+      pcm[i * channels + ch] = y;
+    }
+
+    bq->z1[ch] = z1;
+    bq->z2[ch] = z2;
+  }
+}
+
+static uint8_t _a_fdn_create(a_fdn* fdn, uint32_t rate) {
+  fdn->pre_length = (uint32_t)(A_FDN_MAX_DELAY * rate) + 1;
+
+  uint32_t total = fdn->pre_length;
+
+  for (uint8_t k = 0; k < 4; ++k) {
+    total += (uint32_t)(a_fdn_lengths[k] * rate) + 1;
+  }
+
+  fdn->pre = (float*)calloc(total, sizeof(float));
+  if (!fdn->pre) {
+    ASTERA_FUNC_DBG("unable to allocate %i samples for reverb\n", total);
+    return 0;
+  }
+
+  float* line = fdn->pre + fdn->pre_length;
+  for (uint8_t k = 0; k < 4; ++k) {
+    fdn->lines[k] = line;
+    line += (uint32_t)(a_fdn_lengths[k] * rate) + 1;
+  }
+
+  return 1;
+}
+
+// Map EFX's reverb values onto the network
+static void _a_fdn_set(a_fdn* fdn, const a_fx_reverb* rv, uint32_t rate) {
+  // Denser reverbs have shorter lines, so their echoes come quicker
+  float scale = 0.5f + 0.5f * rv->density;
+  float decay = (rv->decay > 0.1f) ? rv->decay : 0.1f;
+
+  for (uint8_t k = 0; k < 4; ++k) {
+    uint32_t length = (uint32_t)(a_fdn_lengths[k] * scale * rate);
+
+    fdn->lengths[k] = (length) ? length : 1;
+    if (fdn->pos[k] >= fdn->lengths[k]) {
+      fdn->pos[k] = 0;
+    }
+
+    // -60dB after decay seconds
+    fdn->feedback[k] = powf(10.f, -3.f * fdn->lengths[k] / (rate * decay));
+  }
+
+  fdn->damp = _a_clamp(1.f - rv->decay_hfratio * rv->gainhf, 0.f, 0.9f, 0.f);
+
+  // 0.5 is a full householder reflection, 0 leaves each line on its own
+  fdn->diffusion = 0.5f * rv->diffusion;
+
+  fdn->refl_tap = (uint32_t)(rv->refl_delay * rate);
+  fdn->late_tap = (uint32_t)((rv->refl_delay + rv->late_delay) * rate);
+
+  if (fdn->refl_tap >= fdn->pre_length) {
+    fdn->refl_tap = fdn->pre_length - 1;
+  }
+
+  if (fdn->late_tap >= fdn->pre_length) {
+    fdn->late_tap = fdn->pre_length - 1;
+  }
+
+  fdn->refl_gain = rv->gain * rv->refl_gain;
+  fdn->wet       = rv->gain * rv->late_gain * 0.25f;
+}
+
+// Run the network over interleaved PCM, writing only the reverb out to wet
+static void _a_fdn_run(a_fdn* fdn, const float* src, float* wet,
+                       uint32_t frames, uint16_t channels) {
+  float mix = 1.f / channels;
+
+  for (uint32_t i = 0; i < frames; ++i) {
+    float in = 0.f;
+    for (uint16_t ch = 0; ch < channels; ++ch) {
+      in += src[i * channels + ch];
+    }
+
+    uint32_t pre = fdn->pre_pos;
+    fdn->pre[pre] = in * mix;
+
+    float early =
+        fdn->pre[(pre + fdn->pre_length - fdn->refl_tap) % fdn->pre_length];
+    float late =
+        fdn->pre[(pre + fdn->pre_length - fdn->late_tap) % fdn->pre_length];
+
+    if (++fdn->pre_pos == fdn->pre_length) {
+      fdn->pre_pos = 0;
+    }
+
+    // The 4 lines run side by side, fixed width for the vectorizer
+    float out[4], sum = 0.f;
+
+    for (uint8_t k = 0; k < 4; ++k) {
+      out[k]      = fdn->lines[k][fdn->pos[k]];
+      fdn->lp[k]  = out[k] + fdn->damp * (fdn->lp[k] - out[k]);
+      sum        += fdn->lp[k];
+    }
+
+    sum *= fdn->diffusion;
+
+    for (uint8_t k = 0; k < 4; ++k) {
+      float v = late + (fdn->lp[k] - sum) * fdn->feedback[k];
+
+      // Keep the tail from decaying into denormals
+      fdn->lines[k][fdn->pos[k]] = (fabsf(v) < 1e-15f) ? 0.f : v;
+
+      if (++fdn->pos[k] >= fdn->lengths[k]) {
+        fdn->pos[k] = 0;
+      }
+    }
+
+    float left  = (out[0] + out[2]) * fdn->wet + early * fdn->refl_gain;
+    float right = (out[1] + out[3]) * fdn->wet + early * fdn->refl_gain;
+
+    if (channels > 1) {
+      wet[i * 2]     = left;
+      wet[i * 2 + 1] = right;
+    } else {
+      wet[i] = (left + right) * 0.5f;
+    }
+  }
+}
+
+// Remake whichever coefficients' slots have changed since they were made
+static void _a_dsp_refresh(a_dsp* dsp) {
+  // Slots destroyed out from under the chain drop out of it
+  if (dsp->reverb && dsp->reverb->type != FX_REVERB) {
+    dsp->reverb = 0;
+  }
+
+  if (dsp->eq && dsp->eq->type != FX_EQ) {
+    dsp->eq = 0;
+  }
+
+  if (dsp->filter && !dsp->filter->type) {
+    dsp->filter = 0;
+  }
+
+  if (dsp->reverb && memcmp(dsp->reverb->data, &dsp->reverb_made,
+                            sizeof(a_fx_reverb)) != 0) {
+    dsp->reverb_made = *(a_fx_reverb*)dsp->reverb->data;
+    _a_fdn_set(&dsp->fdn, &dsp->reverb_made, dsp->rate);
+  }
+
+  if (dsp->eq &&
+      memcmp(dsp->eq->data, &dsp->eq_made, sizeof(a_fx_eq)) != 0) {
+    a_fx_eq* eq  = &dsp->eq_made;
+    dsp->eq_made = *(a_fx_eq*)dsp->eq->data;
+
+    _a_biquad_shelf(&dsp->bands[0], 0, eq->low_cutoff, eq->low_gain,
+                    dsp->rate);
+    _a_biquad_peak(&dsp->bands[1], eq->mid1_center, eq->mid1_gain,
+                   eq->mid1_width, dsp->rate);
+    _a_biquad_peak(&dsp->bands[2], eq->mid2_center, eq->mid2_gain,
+                   eq->mid2_width, dsp->rate);
+    _a_biquad_shelf(&dsp->bands[3], 1, eq->high_cutoff, eq->high_gain,
+                    dsp->rate);
+  }
+
+  if (dsp->filter &&
+      memcmp(dsp->filter, &dsp->filter_made, sizeof(a_filter)) != 0) {
+    a_filter* filter = &dsp->filter_made;
+    dsp->filter_made = *dsp->filter;
+    dsp->filter_gain = filter->gain;
+
+    // Like EFX, the HF / LF gains are shelves at its reference frequencies
+    switch (filter->type) {
+      case FILTER_LOW:
+        _a_biquad_shelf(&dsp->shelves[0], 1, A_FILTER_HF_REFERENCE,
+                        filter->data.low.gainhf, dsp->rate);
+        dsp->shelf_count = 1;
+        break;
+      case FILTER_HIGH:
+        _a_biquad_shelf(&dsp->shelves[0], 0, A_FILTER_LF_REFERENCE,
+                        filter->data.high.gainlf, dsp->rate);
+        dsp->shelf_count = 1;
+        break;
+      case FILTER_BAND:
+        _a_biquad_shelf(&dsp->shelves[0], 0, A_FILTER_LF_REFERENCE,
+                        filter->data.band.gainlf, dsp->rate);
+        _a_biquad_shelf(&dsp->shelves[1], 1, A_FILTER_HF_REFERENCE,
+                        filter->data.band.gainhf, dsp->rate);
+        dsp->shelf_count = 2;
+        break;
+    }
+  }
+}
+
+static void _a_dsp_destroy(a_dsp* dsp) {
+  if (!dsp) {
+    return;
+  }
+
+  free(dsp->fdn.pre);
+  free(dsp->wet);
+  free(dsp);
+}
+
+// Build a software chain for a request's effects & filters
+// samples - the most samples the chain is run on at once
+// returns: the chain, 0 = none needed (or unable to allocate)
+static a_dsp* _a_dsp_create(a_ctx* ctx, a_req* req, uint32_t rate,
+                            uint16_t channels, uint32_t samples) {
+  a_fx*     reverb = 0;
+  a_fx*     eq     = 0;
+  a_filter* filter = 0;
+
+  // One of each effect, & the last filter like AL_DIRECT_FILTER
+  for (uint16_t i = 0; i < req->fx_count; ++i) {
+    if (req->fx[i] > 0 && req->fx[i] <= ctx->fx_capacity) {
+      a_fx* slot = &ctx->fx_slots[req->fx[i] - 1];
+
+      if (slot->type == FX_REVERB && !reverb) {
+        reverb = slot;
+      } else if (slot->type == FX_EQ && !eq) {
+        eq = slot;
+      }
+    }
+  }
+
+  for (uint16_t i = 0; i < req->filter_count; ++i) {
+    if (req->filters[i] > 0 && req->filters[i] <= ctx->filter_capacity &&
+        ctx->filter_slots[req->filters[i] - 1].type) {
+      filter = &ctx->filter_slots[req->filters[i] - 1];
+    }
+  }
+
+  if (!reverb && !eq && !filter) {
+    return 0;
+  }
+
+  a_dsp* dsp = (a_dsp*)calloc(1, sizeof(a_dsp));
+  if (!dsp) {
+    ASTERA_FUNC_DBG("unable to allocate effect chain\n");
+    return 0;
+  }
+
+  dsp->rate     = rate;
+  dsp->channels = (channels > 1) ? 2 : 1;
+  dsp->eq       = eq;
+  dsp->filter   = filter;
+
+  if (reverb) {
+    dsp->wet = (float*)malloc(sizeof(float) * samples);
+
+    if (dsp->wet && _a_fdn_create(&dsp->fdn, rate)) {
+      dsp->reverb = reverb;
+    }
+  }
+
+  // Differ from every slot so everything is made on the first run
+  memset(&dsp->reverb_made, 0xFF, sizeof(a_fx_reverb));
+  memset(&dsp->eq_made, 0xFF, sizeof(a_fx_eq));
+  memset(&dsp->filter_made, 0xFF, sizeof(a_filter));
+
+  _a_dsp_refresh(dsp);
+
+  return dsp;
+}
+
+// Run a chain over interleaved PCM in place
+static void _a_dsp_run(a_dsp* dsp, float* pcm, uint32_t samples) {
+  time_s   start  = s_get_time();
+  uint32_t frames = samples / dsp->channels;
+
+  _a_dsp_refresh(dsp);
+
+  // EQ feeds both paths, the reverb is sent from before the filter
+  if (dsp->eq) {
+    for (uint8_t b = 0; b < 4; ++b) {
+      _a_biquad_run(&dsp->bands[b], pcm, frames, dsp->channels);
+    }
+  }
+
+  if (dsp->reverb) {
+    _a_fdn_run(&dsp->fdn, pcm, dsp->wet, frames, dsp->channels);
+  }
+
+  if (dsp->filter) {
+    for (uint8_t b = 0; b < dsp->shelf_count; ++b) {
+      _a_biquad_run(&dsp->shelves[b], pcm, frames, dsp->channels);
+    }
+
+    float gain = dsp->filter_gain;
+    for (uint32_t i = 0; i < samples; ++i) {
+      pcm[i] *= gain;
+    }
+  }
+
+  if (dsp->reverb) {
+    const float* wet = dsp->wet;
+    for (uint32_t i = 0; i < samples; ++i) {
+      pcm[i] += wet[i];
+    }
+  }
+
+  dsp->time += s_get_time() - start;
+}
+
+// Read frames out of whichever decoder a song uses
+// returns: the number of frames read
+static int32_t _a_song_read(a_song* song, float* dst, uint32_t samples) {
+  int32_t frames;
+
+  if (song->wav) {
+    frames = _a_wav_read(song->wav, song->channels, dst, samples);
+  } else {
+    frames = stb_vorbis_get_samples_float_interleaved(
+        song->vorbis, song->channels, dst, samples);
+  }
+
+  if (frames > 0) {
+    song->samples_decoded += (uint32_t)frames * song->channels;
+  }
+
+  return frames;
+}
+
+static void _a_song_seek(a_song* song, uint32_t frame) {
+  if (song->wav) {
+    uint32_t offset = frame * (song->wav->bits / 8) * song->channels;
+    song->wav->read =
+        (offset > song->wav->pcm_length) ? song->wav->pcm_length : offset;
+  } else if (frame == 0) {
+    stb_vorbis_seek_start(song->vorbis);
+  } else {
+    stb_vorbis_seek_frame(song->vorbis, frame);
+  }
+}
+
+// The frame a song's decoder will read next
+static uint32_t _a_song_tell(a_song* song) {
+  if (song->wav) {
+    return song->wav->read / ((song->wav->bits / 8) * song->channels);
+  }
+
+  return stb_vorbis_get_sample_offset(song->vorbis);
+}
+
+// Close whichever decoder a song reads from
+static void _a_song_close(a_song* song) {
+  if (song->vorbis) {
+    stb_vorbis_close(song->vorbis);
+  }
+
+  if (song->wav) {
+    if (song->wav->file) {
+      fclose((FILE*)song->wav->file);
+    }
+    free(song->wav);
+  }
+
+  if (song->map) {
+    s_map_close(song->map);
+    song->data = 0;
+  }
+
+  _a_dsp_destroy(song->dsp);
+  song->dsp = 0;
+
+  song->vorbis = 0;
+  song->wav    = 0;
+  song->map    = 0;
+}
+
+// Put a song back at its start with nothing queued
+static void _a_song_rewind(a_song* song) {
+  song->delta         = 0.f;
+  song->curr          = 0.f;
+  song->sample_offset = 0;
+
+  _a_song_seek(song, 0);
+
+  // Unqueue anything existing
+  alSourceStop(song->source);
+  alSourceUnqueueBuffers(song->source, song->buffer_count, song->buffers);
+
+  _a_song_ring_clear(song);
+}
+
+// Decode a buffer's worth of a song into its pcm
+// returns: the number of samples decoded (frames * channels)
+static uint32_t _a_song_decode(a_song* song) {
+  int32_t frames = _a_song_read(song, song->pcm, song->buffer_samples);
+
+  return (frames > 0) ? (uint32_t)frames * song->channels : 0;
+}
+
+// Send a song's pcm to one of its buffers, as float if OpenAL takes it
+static void _a_song_upload(a_song* song, uint32_t buffer, uint32_t samples) {
+  if (song->dsp) {
+    _a_dsp_run(song->dsp, song->pcm, samples);
+  }
+
+  if (!song->pcm16) {
+    alBufferData(buffer, song->format, song->pcm, samples * sizeof(float),
+                 song->info.sample_rate);
+    return;
+  }
+
+  _a_float_to_s16(song->pcm, song->pcm16, samples);
+  alBufferData(buffer, song->format, song->pcm16, samples * sizeof(int16_t),
+               song->info.sample_rate);
+}
+
+// Decode & queue one of a song's buffers from wherever its decoder is
+static void _a_song_prime(a_song* song, uint8_t index) {
+  uint32_t buffer  = song->buffers[index];
+  uint32_t samples = _a_song_decode(song);
+
+  song->buffer_sizes[index] = samples / song->channels;
+
+  _a_song_upload(song, buffer, samples);
+  alSourceQueueBuffers(song->source, 1, &buffer);
+}
+
+// Have the OS read in what a mapped song's decoder needs next, so refills
+// don't fault its pages in one at a time. A window at a time, re-issued once
+// the decoder is halfway through the last one (or has seeked out of it)
+static void _a_song_prefetch(a_song* song) {
+  if (!song->map || !song->vorbis) {
+    return;
+  }
+
+  const uint64_t window = ASTERA_AUDIO_MAP_PREFETCH;
+  uint64_t       offset = stb_vorbis_get_file_offset(song->vorbis);
+
+  if (song->prefetched && offset + window / 2 < song->prefetched &&
+      offset + window >= song->prefetched) {
+    return;
+  }
+
+  s_map_prefetch(song->map,
+                 (uint64_t)(song->data - s_map_data(song->map)) + offset,
+                 window);
+  song->prefetched = offset + window;
+}
+
+// Prime the next buffer of a song waiting to start a crossfade
+static void _a_song_prime_next(a_song* song) {
+  uint32_t priming = s_atomic_load(&song->priming);
+
+  _a_song_prime(song, song->buffer_count - priming);
+  s_atomic_store(&song->priming, priming - 1);
+}
+
+// Note how much of a song's queue was left when it came to be refilled
+// proc - the number of buffers already played out
+// ended - if the song has nothing left to queue (so running dry is expected)
+static void _a_song_depth(a_song* song, int32_t proc, uint8_t ended) {
+  song->queued = (uint8_t)(song->buffer_count - proc);
+
+  if (song->queued || ended) {
+    song->starved = 0;
+    return;
+  }
+
+  // Count the queue running dry once, not every pass until it's refilled
+  if (!song->starved) {
+    song->starved = 1;
+    ++song->underruns;
+    song->last_underrun = s_get_time();
+
+    ASTERA_DBG("[%.2f] song %i ran out of queued audio, %i buffers of %i "
+               "samples\n",
+               song->last_underrun, song->id, song->buffer_count,
+               song->buffer_samples);
+  }
+}
+
+static uint8_t _a_song_reset(a_song* song) {
+  _a_song_rewind(song);
+
+  for (uint8_t i = 0; i < song->buffer_count; ++i) {
+    _a_song_prime(song, i);
+  }
+
+  return 1;
+}
+
+// Put a song at a time (milliseconds) with its queue primed from there
+static void _a_song_cue(a_song* song, time_s time) {
+  _a_song_rewind(song);
+
+  uint32_t frame = (uint32_t)(time / MS_TO_SEC * song->info.sample_rate);
+  if (frame < song->sample_count) {
+    _a_song_seek(song, frame);
+    song->curr  = time;
+    song->delta = time;
+  }
+
+  for (uint8_t i = 0; i < song->buffer_count; ++i) {
+    _a_song_prime(song, i);
+  }
+}
+
+// Build a song's software effect chain for a request, if it needs one
+static void _a_song_dsp(a_ctx* ctx, a_song* song, a_req* req) {
+  _a_dsp_destroy(song->dsp);
+  song->dsp = 0;
+
+  if (ctx->soft_fx) {
+    song->dsp = _a_dsp_create(ctx, req, song->info.sample_rate,
+                              song->channels, song->buffer_samples);
+  }
+}
+
+// Apply the request's dynamic values to a playing song's source
+static void _a_song_apply(a_ctx* ctx, a_song* song) {
+  ctx->al_calls += _a_source_push(song->source, &song->sent, song->req,
+                                  _a_get_gain(ctx, song->id, 0) * song->fade,
+                                  1.f, 0);
+}
+
+static uint8_t _a_song_ring_create(a_song* song) {
+  uint32_t wanted =
+      song->buffer_samples * song->buffer_count * ASTERA_SONG_RING_SCALE;
+  uint32_t length = 1;
+
+  // Power of 2 so the running head & tail can wrap freely
+  while (length < wanted) {
+    length <<= 1;
+  }
+
+  song->ring = (float*)malloc(sizeof(float) * length);
+
+  if (!song->ring) {
+    ASTERA_FUNC_DBG("unable to allocate %i samples for song ring\n", length);
+    return 0;
+  }
+
+  song->ring_length = length;
+  _a_song_ring_clear(song);
+
+  return 1;
+}
+
+// Decode into the ring until it's full or the stream ends
+static void _a_song_decode_ahead(a_song* song) {
+  uint32_t head    = song->ring_head;
+  uint32_t tail    = s_atomic_load(&song->ring_tail);
+  uint8_t  rewound = 0;
+
+  while (!song->decoded) {
+    _a_song_prefetch(song);
+
+    uint32_t space = song->ring_length - (head - tail);
+    uint32_t index = head & (song->ring_length - 1);
+    uint32_t run   = song->ring_length - index;
+
+    if (run > space) {
+      run = space;
+    }
+
+    if (run < (uint32_t)song->channels) {
+      break;
+    }
+
+    int32_t frames = _a_song_read(song, song->ring + index, run);
+
+    if (frames > 0) {
+      head += frames * song->channels;
+      s_atomic_store(&song->ring_head, head);
+      rewound = 0;
+      continue;
+    }
+
+    // Loop without a gap by rewinding the decoder, not the source
+    if (song->req && song->req->loop && !rewound) {
+      _a_song_seek(song, 0);
+      ++song->req->loop_count;
+      rewound = 1;
+    } else {
+      song->decoded = 1;
+    }
+  }
+}
+
+// Refill a song's processed OpenAL buffers from its ring
+static void _a_song_stream(a_song* song) {
+  if (!song->ring && !_a_song_ring_create(song)) {
+    return;
+  }
+
+  _a_song_decode_ahead(song);
+
+  ALint proc;
+  alGetSourcei(song->source, AL_BUFFERS_PROCESSED, &proc);
+
+  _a_song_depth(song, proc,
+                song->decoded &&
+                    s_atomic_load(&song->ring_head) == song->ring_tail);
+
+  while (proc > 0) {
+    uint32_t tail      = song->ring_tail;
+    uint32_t available = s_atomic_load(&song->ring_head) - tail;
+
+    if (!available) {
+      break;
+    }
+
+    if (available > song->buffer_samples) {
+      available = song->buffer_samples;
+    }
+
+    uint32_t index = tail & (song->ring_length - 1);
+    uint32_t first = song->ring_length - index;
+
+    if (first > available) {
+      first = available;
+    }
+
+    memcpy(song->pcm, song->ring + index, sizeof(float) * first);
+    memcpy(song->pcm + first, song->ring, sizeof(float) * (available - first));
+    s_atomic_store(&song->ring_tail, tail + available);
+
+    uint32_t buffer;
+    alSourceUnqueueBuffers(song->source, 1, &buffer);
+
+    for (uint8_t i = 0; i < song->buffer_count; ++i) {
+      if (song->buffers[i] == buffer) {
+        song->curr += ((time_s)song->buffer_sizes[i] / song->info.sample_rate) *
+                      1000.0;
+        song->buffer_sizes[i] = available / song->channels;
+        break;
+      }
+    }
+
+    _a_song_upload(song, buffer, available);
+    alSourceQueueBuffers(song->source, 1, &buffer);
+
+    --proc;
+    _a_song_decode_ahead(song);
+  }
+
+  float sec_offset;
+  alGetSourcef(song->source, AL_SEC_OFFSET, &sec_offset);
+
+  song->delta = song->curr + (sec_offset * 1000.f);
+  if (song->length > 0) {
+    song->delta = fmod(song->delta, song->length);
+  }
+
+  song->req->time = song->delta;
+
+  ALenum state;
+  alGetSourcei(song->source, AL_SOURCE_STATE, &state);
+
+  if (state == AL_STOPPED) {
+    if (proc == 0) {
+      // The queue ran dry before we refilled it, every buffer is fresh again
+      alSourcePlay(song->source);
+      state = AL_PLAYING;
+    } else if (song->decoded && song->ring_head == song->ring_tail) {
+      song->playing    = 0;
+      song->req->state = AL_STOPPED;
+      return;
+    }
+  }
+
+  song->req->state = state;
+}
+
+// A song's counters from before it decodes, for the context's stats
+typedef struct {
+  time_s   start, dsp;
+  uint32_t samples, underruns;
+} a_profile;
+
+static a_profile _a_profile_begin(a_song* song) {
+  return (a_profile){.start     = s_get_time(),
+                     .dsp       = (song->dsp) ? song->dsp->time : 0,
+                     .samples   = song->samples_decoded,
+                     .underruns = song->underruns};
+}
+
+// Add what a song's decode took to the context's running totals
+static void _a_profile_end(a_ctx* ctx, a_song* song, a_profile* profile) {
+  ctx->decode_time += s_get_time() - profile->start;
+  ctx->decode_samples += song->samples_decoded - profile->samples;
+
+  if (song->dsp) {
+    ctx->dsp_time += song->dsp->time - profile->dsp;
+  }
+
+  if (song->underruns != profile->underruns) {
+    ctx->underruns += song->underruns - profile->underruns;
+    ctx->last_underrun      = song->last_underrun;
+    ctx->last_underrun_song = song->id;
+  }
+}
+
+static int32_t _a_stream_thread(void* data) {
+  a_ctx* ctx = (a_ctx*)data;
+
+  while (s_atomic_load(&ctx->stream_run)) {
+    s_mutex_lock(ctx->stream_lock);
+
+    for (uint16_t i = 0; i < ctx->song_high; ++i) {
+      a_song* song = &ctx->songs[i];
+
+      if (!song->buffers) {
+        continue;
+      }
+
+      a_profile profile = _a_profile_begin(song);
+
+      // Priming shares the pass with refills, a buffer at a time
+      if (song->starting && s_atomic_load(&song->priming)) {
+        _a_song_prime_next(song);
+      } else if (song->req && song->playing) {
+        _a_song_stream(song);
+      }
+
+      _a_profile_end(ctx, song, &profile);
+    }
+
+    s_mutex_unlock(ctx->stream_lock);
+    s_sleep(ctx->stream_interval);
+  }
+
+  return 0;
+}
+
+static void _a_song_lock(a_ctx* ctx) {
+  if (ctx->stream_lock) {
+    s_mutex_lock(ctx->stream_lock);
+  }
+}
+
+static void _a_song_unlock(a_ctx* ctx) {
+  if (ctx->stream_lock) {
+    s_mutex_unlock(ctx->stream_lock);
+  }
+}
+
+// Start a primed crossfade song & fade its partner out alongside it
+static void _a_song_begin(a_ctx* ctx, a_song* song, time_s now) {
+  _a_song_lock(ctx);
+
+  song->starting   = 0;
+  song->playing    = 1;
+  song->fade       = 0.f;
+  song->fade_from  = 0.f;
+  song->fade_to    = 1.f;
+  song->fade_start = now;
+  song->fading     = 1;
+  song->sent.valid = 0;
+
+  if (song->fade_partner) {
+    a_song* from = &ctx->songs[song->fade_partner - 1];
+
+    if (from->req && from->playing) {
+      from->fade_from   = from->fade;
+      from->fade_to     = 0.f;
+      from->fade_start  = now;
+      from->fade_length = song->fade_length;
+      from->fading      = 1;
+      from->fade_stop   = 1;
+    }
+
+    song->fade_partner = 0;
+  }
+
+  // Silent until the fade's first step so it doesn't pop in
+  _a_song_apply(ctx, song);
+  alSourcePlay(song->source);
+
+  _a_song_unlock(ctx);
+}
+
+// Move a song's fade along
+// returns: 1 = still playing, 0 = stopped once faded out
+static uint8_t _a_song_fade(a_ctx* ctx, a_song* song, time_s now) {
+  time_s t = (song->fade_length > 0)
+                 ? (now - song->fade_start) / song->fade_length
+                 : 1.0;
+
+  if (t < 1.0) {
+    song->fade = song->fade_from + (song->fade_to - song->fade_from) * (float)t;
+    return 1;
+  }
+
+  song->fade   = song->fade_to;
+  song->fading = 0;
+
+  if (song->fade_stop) {
+    a_song_stop(ctx, song->id);
+    song->req->state = AL_STOPPED;
+    return 0;
+  }
+
+  return 1;
+}
+
+uint8_t a_ctx_start_stream(a_ctx* ctx, time_s interval) {
+  if (ctx->stream) {
+    ASTERA_FUNC_DBG("context is already streaming.\n");
+    return 0;
+  }
+
+  if (!ctx->pcm_length) {
+    ASTERA_FUNC_DBG("context has no pcm size to stream with.\n");
+    return 0;
+  }
+
+  if (ctx->render) {
+    ASTERA_FUNC_DBG("loopback contexts decode in a_ctx_update to stay "
+                    "deterministic.\n");
+    return 0;
+  }
+
+  ctx->stream_lock = s_mutex_create();
+
+  if (!ctx->stream_lock) {
+    ASTERA_FUNC_DBG("unable to create streaming lock.\n");
+    return 0;
+  }
+
+  ctx->stream_interval =
+      (interval > 0) ? interval : ASTERA_AUDIO_STREAM_INTERVAL;
+
+  // Pick up the songs that are already playing
+  for (uint16_t i = 0; i < ctx->song_high; ++i) {
+    a_song* song = &ctx->songs[i];
+
+    if (song->buffers && song->req) {
+      ALenum state;
+      alGetSourcei(song->source, AL_SOURCE_STATE, &state);
+      song->playing = state == AL_PLAYING;
+    }
+  }
+
+  s_atomic_store(&ctx->stream_run, 1);
+  ctx->stream = s_thread_create(_a_stream_thread, ctx);
+
+  if (!ctx->stream) {
+    ASTERA_FUNC_DBG("unable to start streaming thread.\n");
+    s_mutex_destroy(ctx->stream_lock);
+    ctx->stream_lock = 0;
+    return 0;
+  }
+
+  return 1;
+}
+
+uint8_t a_ctx_stop_stream(a_ctx* ctx) {
+  if (!ctx->stream) {
+    ASTERA_FUNC_DBG("context isn't streaming.\n");
+    return 0;
+  }
+
+  s_atomic_store(&ctx->stream_run, 0);
+  s_thread_join(ctx->stream);
+
+  // Whatever was decoded ahead is dropped, a_ctx_update picks up from the
+  // decoder's position
+  for (uint16_t i = 0; i < ctx->song_high; ++i) {
+    a_song* song = &ctx->songs[i];
+
+    if (song->ring) {
+      free(song->ring);
+      song->ring        = 0;
+      song->ring_length = 0;
+    }
+  }
+
+  s_mutex_destroy(ctx->stream_lock);
+
+  ctx->stream      = 0;
+  ctx->stream_lock = 0;
+
+  return 1;
+}
+
+uint8_t a_ctx_set_pcm_cache(a_ctx* ctx, const char* directory,
+                            uint32_t budget) {
+  if (!ctx) {
+    ASTERA_FUNC_DBG("no context passed.\n");
+    return 0;
+  }
+
+  if (ctx->decoder && directory != ctx->pcm_cache) {
+    ASTERA_FUNC_DBG("unable to change the cache directory while decoding.\n");
+    return 0;
+  }
+
+  ctx->pcm_cache  = directory;
+  ctx->pcm_budget = (budget) ? budget : ASTERA_AUDIO_PCM_BUDGET;
+
+  _a_buf_evict(ctx, 0);
+
+  return 1;
+}
+
+uint8_t a_ctx_set_resample(a_ctx* ctx, uint8_t resample) {
+  if (!ctx) {
+    ASTERA_FUNC_DBG("no context passed.\n");
+    return 0;
+  }
+
+  ctx->buf_rate = (resample) ? ctx->mix_rate : 0;
+
+  return 1;
+}
+
+uint8_t a_ctx_set_seed(a_ctx* ctx, uint32_t seed) {
+  if (!ctx) {
+    ASTERA_FUNC_DBG("no context passed.\n");
+    return 0;
+  }
+
+  // xorshift never leaves 0
+  ctx->rng = (seed) ? seed : 0x9E3779B9u;
+
+  return 1;
+}
+
+void a_efx_info(a_ctx* ctx) {
+  if (alcIsExtensionPresent(ctx->device, "ALC_EXT_EFX") == AL_FALSE) {
+    ASTERA_FUNC_DBG("No ALC_EXT_EFX.\n");
+  } else {
+    ASTERA_FUNC_DBG("ALC_EXT_EFX Present.\n");
+  }
+
+  uint32_t s_sends = 0;
+#if !defined(ASTERA_AL_NO_FX) && defined(ALC_MAX_AUXILIARY_SENDS)
+  s_sends = ALC_MAX_AUXILIARY_SENDS;
+#endif
+  ASTERA_FUNC_DBG("MAX_AUXILIARY_SENDS: %i\n", s_sends);
+}
+
+const char* a_ctx_get_device(a_ctx* ctx, uint8_t* string_length) {
+  const ALchar* name;
+
+  if (ctx->device) {
+    name = alcGetString(ctx->device, ALC_DEVICE_SPECIFIER);
+  } else {
+    name = alcGetString(0, ALC_DEFAULT_DEVICE_SPECIFIER);
+  }
+
+  uint8_t length = strlen(name);
+
+  if (string_length) {
+    *string_length = length;
+  }
+
+  return name;
+}
+
+uint8_t a_can_play(a_ctx* ctx) { return ctx->allow; }
+
+a_stats a_ctx_get_stats(a_ctx* ctx) { return ctx->stats; }
+
+uint8_t a_ctx_post(a_ctx* ctx, a_cmd cmd) {
+  if (!ctx->cmds) {
+    ASTERA_FUNC_DBG("context has no command queue.\n");
+    return 0;
+  }
+
+  const uint32_t mask = ASTERA_AUDIO_CMD_CAPACITY - 1;
+  uint32_t       pos  = s_atomic_load(&ctx->cmd_write);
+
+  // Claim a slot, a slot is free once its sequence matches the position
+  for (;;) {
+    uint32_t sequence = s_atomic_load(&ctx->cmd_sequences[pos & mask]);
+    int32_t  diff     = (int32_t)(sequence - pos);
+
+    if (diff == 0) {
+      if (s_atomic_cas(&ctx->cmd_write, pos, pos + 1)) {
+        break;
+      }
+    } else if (diff < 0) {
+      ASTERA_FUNC_DBG("command queue full.\n");
+      return 0;
+    }
+
+    pos = s_atomic_load(&ctx->cmd_write);
+  }
+
+  ctx->cmds[pos & mask] = cmd;
+  s_atomic_store(&ctx->cmd_sequences[pos & mask], pos + 1);
+
+  return 1;
+}
+
+// If a queued play's request was stopped before the play got to run
+static uint8_t _a_cmd_cancelled(a_cmd* cmd) {
+  if (cmd->req && cmd->req->stop) {
+    cmd->req->state = AL_STOPPED;
+    return 1;
+  }
+
+  return 0;
+}
+
+static void _a_cmd_run(a_ctx* ctx, a_cmd* cmd) {
+  switch (cmd->type) {
+    case A_CMD_SFX_PLAY:
+      if (!_a_cmd_cancelled(cmd)) {
+        a_sfx_play(ctx, cmd->layer, cmd->id, cmd->req);
+      }
+      break;
+    case A_CMD_SFX_STOP:
+      a_sfx_stop(ctx, cmd->id);
+      break;
+    case A_CMD_SFX_PAUSE:
+      a_sfx_pause(ctx, cmd->id);
+      break;
+    case A_CMD_SFX_RESUME:
+      a_sfx_resume(ctx, cmd->id);
+      break;
+    case A_CMD_SONG_PLAY:
+      if (!_a_cmd_cancelled(cmd)) {
+        a_song_play(ctx, cmd->layer, cmd->id, cmd->req);
+      }
+      break;
+    case A_CMD_SONG_STOP:
+      a_song_stop(ctx, cmd->id);
+      break;
+    case A_CMD_SONG_PAUSE:
+      a_song_pause(ctx, cmd->id);
+      break;
+    case A_CMD_SONG_RESUME:
+      a_song_resume(ctx, cmd->id);
+      break;
+    case A_CMD_LAYER_GAIN:
+      a_layer_set_gain(ctx, cmd->layer, cmd->gain);
+      break;
+    case A_CMD_LISTENER_GAIN:
+      a_listener_set_gain(ctx, cmd->gain);
+      break;
+    case A_CMD_LISTENER_POS:
+      a_listener_set_pos(ctx, cmd->values);
+      break;
+    case A_CMD_LISTENER_VEL:
+      a_listener_set_vel(ctx, cmd->values);
+      break;
+    case A_CMD_LISTENER_ORI:
+      a_listener_set_ori(ctx, cmd->values);
+      break;
+    case A_CMD_NONE:
+      break;
+  }
+}
+
+// Run every command published before this call
+static void _a_cmd_drain(a_ctx* ctx) {
+  const uint32_t mask = ASTERA_AUDIO_CMD_CAPACITY - 1;
+
+  if (!ctx->cmds) {
+    return;
+  }
+
+  for (;;) {
+    uint32_t pos      = ctx->cmd_read;
+    uint32_t sequence = s_atomic_load(&ctx->cmd_sequences[pos & mask]);
+
+    if (sequence != pos + 1) {
+      break;
+    }
+
+    a_cmd cmd = ctx->cmds[pos & mask];
+    s_atomic_store(&ctx->cmd_sequences[pos & mask],
+                   pos + ASTERA_AUDIO_CMD_CAPACITY);
+    ctx->cmd_read = pos + 1;
+
+    _a_cmd_run(ctx, &cmd);
+  }
+}
+
+// format - 0 terminated context attributes for the device's output format
+//          (optional, 0 to let the device choose)
+static a_ctx* _a_ctx_create(ALCdevice* al_device, const int* format,
+                            uint8_t layers, uint16_t max_sfx,
+                            uint16_t max_buffers, uint16_t max_songs,
+                            uint16_t max_fx, uint16_t max_filters,
+                            uint32_t pcm_size) {
+  a_ctx* ctx = (a_ctx*)calloc(1, sizeof(a_ctx));
+
+  if (!ctx) {
+    ASTERA_FUNC_DBG("unable to malloc initial space for context.\n");
+    alcCloseDevice(al_device);
+    return 0;
+  }
+
+#if !defined(ASTERA_AL_NO_FX)
+  if (alcIsExtensionPresent(al_device, "ALC_EXT_EFX") == AL_FALSE) {
+    ctx->use_fx = 0;
+  } else {
+    ctx->use_fx = 1;
+  }
+
+  // Disable effects if we're not using any of them
+  if (!max_fx && !max_filters) {
+    ctx->use_fx = 0;
+  }
+#else
+  ctx->use_fx = 0;
+#endif
+
+  int     attribs[10] = {0};
+  uint8_t attrib      = 0;
+
+  while (format && format[attrib] && attrib < 6) {
+    attribs[attrib] = format[attrib];
+    ++attrib;
+  }
+
+#if !defined(ASTERA_AL_NO_FX) && defined(ALC_MAX_AUXILIARY_SENDS)
+  if (ctx->use_fx) {
+    attribs[attrib]     = ALC_MAX_AUXILIARY_SENDS;
+    attribs[attrib + 1] = 4;
+  }
+#endif
+
+  ALCcontext* context = alcCreateContext(al_device, attribs);
+
+  if (!alcMakeContextCurrent(context)) {
+    ASTERA_FUNC_DBG("Error creating OpenAL Context\n");
+    if (context) {
+      alcDestroyContext(context);
+    }
+    alcCloseDevice(al_device);
+    free(ctx);
+    return 0;
+  }
+
+  ctx->context = context;
+  ctx->device  = al_device;
+
+#if defined(ASTERA_AL_DISTANCE_MODEL)
+  alDistanceModel(ASTERA_AL_DISTANCE_MODEL);
+#endif
+
+  if (alIsExtensionPresent("AL_SOFT_deferred_updates") == AL_TRUE) {
+    ctx->defer_updates   = (a_al_proc)alGetProcAddress("alDeferUpdatesSOFT");
+    ctx->process_updates = (a_al_proc)alGetProcAddress("alProcessUpdatesSOFT");
+
+    if (!ctx->defer_updates || !ctx->process_updates) {
+      ctx->defer_updates   = 0;
+      ctx->process_updates = 0;
+    }
+  }
+
+  ALCint mix_rate = 0;
+  alcGetIntegerv(al_device, ALC_FREQUENCY, 1, &mix_rate);
+  ctx->mix_rate = (mix_rate > 0) ? (uint32_t)mix_rate : 44100;
+
+  if (alcIsExtensionPresent(al_device, "ALC_SOFT_device_clock") == ALC_TRUE) {
+    ctx->device_clock = (a_alc_get_int64)alcGetProcAddress(
+        al_device, "alcGetInteger64vSOFT");
+  }
+
+  // Starting at a time is in terms of the device clock, so it needs both
+  if (ctx->device_clock &&
+      alIsExtensionPresent("AL_SOFT_source_start_delay") == AL_TRUE) {
+    ctx->play_at = (a_al_play_at)alGetProcAddress("alSourcePlayAtTimeSOFT");
+  }
+
+#if !defined(ASTERA_AL_NO_FX)
+  if (ctx->use_fx) {
+    ALint fx_per_source;
+    alcGetIntegerv(al_device, ALC_MAX_AUXILIARY_SENDS, 1, &fx_per_source);
+    ctx->fx_per_source = (uint16_t)fx_per_source;
+
+    if (!ctx->fx_per_source) {
+      ASTERA_FUNC_DBG("0 effects allowed per source, disabling effects.\n");
+      ctx->use_fx = 0;
+    }
+  }
+
+  if (ctx->use_fx) {
+#define LOAD_PROC(T, x) ((x) = (T)alGetProcAddress(#x))
+    LOAD_PROC(LPALGENEFFECTS, alGenEffects);
+    LOAD_PROC(LPALGENFILTERS, alGenFilters);
+    LOAD_PROC(LPALDELETEEFFECTS, alDeleteEffects);
+    LOAD_PROC(LPALDELETEFILTERS, alDeleteFilters);
+    LOAD_PROC(LPALISEFFECT, alIsEffect);
+    LOAD_PROC(LPALEFFECTI, alEffecti);
+    LOAD_PROC(LPALEFFECTIV, alEffectiv);
+    LOAD_PROC(LPALEFFECTF, alEffectf);
+    LOAD_PROC(LPALEFFECTFV, alEffectfv);
+    LOAD_PROC(LPALGETEFFECTI, alGetEffecti);
+    LOAD_PROC(LPALGETEFFECTIV, alGetEffectiv);
+    LOAD_PROC(LPALGETEFFECTF, alGetEffectf);
+    LOAD_PROC(LPALGETEFFECTFV, alGetEffectfv);
+
+    LOAD_PROC(LPALFILTERF, alFilterf);
+    LOAD_PROC(LPALFILTERI, alFilteri);
+
+    LOAD_PROC(LPALGENAUXILIARYEFFECTSLOTS, alGenAuxiliaryEffectSlots);
+    LOAD_PROC(LPALDELETEAUXILIARYEFFECTSLOTS, alDeleteAuxiliaryEffectSlots);
+    LOAD_PROC(LPALISAUXILIARYEFFECTSLOT, alIsAuxiliaryEffectSlot);
+    LOAD_PROC(LPALAUXILIARYEFFECTSLOTI, alAuxiliaryEffectSloti);
+    LOAD_PROC(LPALAUXILIARYEFFECTSLOTIV, alAuxiliaryEffectSlotiv);
+
+    LOAD_PROC(LPALAUXILIARYEFFECTSLOTF, alAuxiliaryEffectSlotf);
+    LOAD_PROC(LPALAUXILIARYEFFECTSLOTFV, alAuxiliaryEffectSlotfv);
+    LOAD_PROC(LPALGETAUXILIARYEFFECTSLOTI, alGetAuxiliaryEffectSloti);
+    LOAD_PROC(LPALGETAUXILIARYEFFECTSLOTIV, alGetAuxiliaryEffectSlotiv);
+    LOAD_PROC(LPALGETAUXILIARYEFFECTSLOTF, alGetAuxiliaryEffectSlotf);
+    LOAD_PROC(LPALGETAUXILIARYEFFECTSLOTFV, alGetAuxiliaryEffectSlotfv);
+
+#undef LOAD_PROC
+  }
+#endif
+
+  // Without EFX, effects & filters run in software on songs
+  ctx->soft_fx = !ctx->use_fx && (max_fx || max_filters);
+
+  ctx->fx_capacity = max_fx;
+  ctx->fx_count    = 0;
+
+  if (max_fx) {
+    ctx->fx_slots = (a_fx*)calloc(ctx->fx_capacity, sizeof(a_fx));
+
+    if (!ctx->fx_slots) {
+      ASTERA_FUNC_DBG("unable to allocate %i fx slots\n", ctx->fx_capacity);
+
+      alcDestroyContext(ctx->context);
+      alcCloseDevice(ctx->device);
+
+      free(ctx);
+      return 0;
+    }
+
+    for (uint16_t i = 0; i < ctx->fx_capacity; ++i) {
+      ctx->fx_slots[i].id = i + 1;
+    }
+  } else {
+    ctx->fx_slots = 0;
+  }
+
+  ctx->filter_count    = 0;
+  ctx->filter_capacity = max_filters;
+
+  if (max_filters) {
+    ctx->filter_slots =
+        (a_filter*)calloc(ctx->filter_capacity, sizeof(a_filter));
+
+    if (!ctx->filter_slots) {
+      ASTERA_FUNC_DBG("unable to allocate %i fx slots\n", ctx->fx_capacity);
+
+      alcDestroyContext(ctx->context);
+      alcCloseDevice(ctx->device);
+
+      free(ctx->fx_slots);
+      free(ctx);
+
+      return 0;
+    }
+
+    for (uint16_t i = 0; i < max_filters; ++i) {
+      ctx->filter_slots[i].id = i + 1;
+    }
+  } else {
+    ctx->filter_slots = 0;
+  }
+
+  ctx->pcm_length = pcm_size;
+  ctx->float32    = alIsExtensionPresent("AL_EXT_FLOAT32") == AL_TRUE;
+
   // Create the resource arrays
   ctx->song_capacity = max_songs;
   ctx->song_count    = 0;
   ctx->song_high     = 0;
 
-  if (max_songs) {
-    ctx->songs      = (a_song*)calloc(ctx->song_capacity, sizeof(a_song));
-    ctx->song_names = (const char**)calloc(ctx->song_capacity, sizeof(char*));
+  if (max_songs) {
+    ctx->songs      = (a_song*)calloc(ctx->song_capacity, sizeof(a_song));
+    ctx->song_names = (const char**)calloc(ctx->song_capacity, sizeof(char*));
+
+    for (uint16_t i = 0; i < max_songs; ++i) {
+      ctx->songs[i].id   = i + 1;
+      ctx->songs[i].fade = 1.f;
+      alGenSources(1, &ctx->songs[i].source);
+      ctx->songs[i].req = 0;
+    }
+  }
+
+  ctx->buffer_count    = 0;
+  ctx->buffer_capacity = max_buffers;
+  ctx->buffer_high     = 0;
+
+  if (max_buffers) {
+    ctx->buffers      = (a_buf*)calloc(max_buffers, sizeof(a_buf));
+    ctx->buffer_names = (const char**)calloc(max_buffers, sizeof(char*));
+
+    for (uint16_t i = 0; i < max_buffers; ++i) {
+      ctx->buffers[i].id = i + 1;
+    }
+  }
+
+  ctx->pcm_budget = ASTERA_AUDIO_PCM_BUDGET;
+
+  ctx->sfx_capacity = max_sfx;
+  ctx->sfx_count    = 0;
+
+  if (max_sfx) {
+    ctx->sfx = (a_sfx*)calloc(ctx->sfx_capacity, sizeof(a_sfx));
+
+    for (uint16_t i = 0; i < max_sfx; ++i) {
+      ctx->sfx[i].id     = i + 1;
+      ctx->sfx[i].source = 0;
+      ctx->sfx[i].req    = 0;
+    }
+
+    // Sfx share a smaller pool of sources, the rest play virtually
+    ctx->voice_count = (max_sfx < ASTERA_AUDIO_MAX_VOICES)
+                           ? max_sfx
+                           : ASTERA_AUDIO_MAX_VOICES;
+    ctx->voice_free  = (uint32_t*)calloc(ctx->voice_count, sizeof(uint32_t));
+    ctx->voice_batch = (uint32_t*)calloc(ctx->voice_count, sizeof(uint32_t));
+
+    if (ctx->voice_free && ctx->voice_batch) {
+      alGenSources(ctx->voice_count, ctx->voice_free);
+      ctx->voice_free_count = ctx->voice_count;
+    } else {
+      ASTERA_FUNC_DBG("unable to allocate %i voices\n", ctx->voice_count);
+      ctx->voice_count = 0;
+    }
+  }
+
+  ctx->last_update = s_get_time();
+  ctx->clock_start = ctx->last_update;
+  ctx->rng         = (uint32_t)(ctx->clock_start * 1000.0) | 1;
+
+  ctx->cmds = (a_cmd*)calloc(ASTERA_AUDIO_CMD_CAPACITY, sizeof(a_cmd));
+  ctx->cmd_sequences = (volatile uint32_t*)calloc(ASTERA_AUDIO_CMD_CAPACITY,
+                                                  sizeof(uint32_t));
+
+  if (ctx->cmds && ctx->cmd_sequences) {
+    for (uint32_t i = 0; i < ASTERA_AUDIO_CMD_CAPACITY; ++i) {
+      ctx->cmd_sequences[i] = i;
+    }
+  } else {
+    ASTERA_FUNC_DBG("unable to allocate command queue.\n");
+    free(ctx->cmds);
+    free((void*)ctx->cmd_sequences);
+    ctx->cmds          = 0;
+    ctx->cmd_sequences = 0;
+  }
+
+  ctx->cmd_write = 0;
+  ctx->cmd_read  = 0;
+
+  ctx->layer_count    = 0;
+  ctx->layer_capacity = layers;
+
+  if (layers) {
+    ctx->layers = (a_layer*)calloc(layers, sizeof(a_layer));
+
+    for (uint16_t i = 0; i < layers; ++i) {
+      ctx->layers[i].gain = 1.f;
+    }
+  }
+
+  ctx->allow = 1;
+  return ctx;
+}
+
+a_ctx* a_ctx_create(const char* device, uint8_t layers, uint16_t max_sfx,
+                    uint16_t max_buffers, uint16_t max_songs, uint16_t max_fx,
+                    uint16_t max_filters, uint32_t pcm_size) {
+  ALCdevice* al_device = alcOpenDevice(device);
+
+  if (!al_device) {
+    ASTERA_FUNC_DBG("unable to open audio device.\n");
+    return 0;
+  }
+
+  return _a_ctx_create(al_device, 0, layers, max_sfx, max_buffers, max_songs,
+                       max_fx, max_filters, pcm_size);
+}
+
+a_ctx* a_ctx_create_loopback(uint32_t sample_rate, uint8_t channels,
+                             uint8_t layers, uint16_t max_sfx,
+                             uint16_t max_buffers, uint16_t max_songs,
+                             uint16_t max_fx, uint16_t max_filters,
+                             uint32_t pcm_size) {
+  if (channels != 1 && channels != 2) {
+    ASTERA_FUNC_DBG("loopback only supports mono & stereo output.\n");
+    return 0;
+  }
+
+  if (alcIsExtensionPresent(0, "ALC_SOFT_loopback") == ALC_FALSE) {
+    ASTERA_FUNC_DBG("ALC_SOFT_loopback isn't available.\n");
+    return 0;
+  }
+
+  a_alc_loopback_open loopback_open =
+      (a_alc_loopback_open)alcGetProcAddress(0, "alcLoopbackOpenDeviceSOFT");
+  a_alc_format_supported format_supported =
+      (a_alc_format_supported)alcGetProcAddress(
+          0, "alcIsRenderFormatSupportedSOFT");
+  a_alc_render render =
+      (a_alc_render)alcGetProcAddress(0, "alcRenderSamplesSOFT");
+
+  if (!loopback_open || !format_supported || !render) {
+    ASTERA_FUNC_DBG("unable to load ALC_SOFT_loopback functions.\n");
+    return 0;
+  }
+
+  ALCdevice* al_device = loopback_open(0);
+
+  if (!al_device) {
+    ASTERA_FUNC_DBG("unable to open loopback device.\n");
+    return 0;
+  }
+
+  int format[7] = {ALC_FORMAT_CHANNELS_SOFT,
+                   (channels > 1) ? ALC_STEREO_SOFT : ALC_MONO_SOFT,
+                   ALC_FORMAT_TYPE_SOFT,
+                   ALC_SHORT_SOFT,
+                   ALC_FREQUENCY,
+                   (int)sample_rate,
+                   0};
+
+  if (!format_supported(al_device, sample_rate, format[1], ALC_SHORT_SOFT)) {
+    ASTERA_FUNC_DBG("unsupported loopback format %iHz, %i channels\n",
+                    sample_rate, channels);
+    alcCloseDevice(al_device);
+    return 0;
+  }
+
+  a_ctx* ctx = _a_ctx_create(al_device, format, layers, max_sfx, max_buffers,
+                             max_songs, max_fx, max_filters, pcm_size);
+
+  if (!ctx) {
+    return 0;
+  }
+
+  ctx->render          = render;
+  ctx->render_rate     = sample_rate;
+  ctx->render_channels = channels;
+  ctx->render_clock    = 0;
+  ctx->render_frames   = 0;
+  ctx->last_update     = 0;
+
+  return ctx;
+}
+
+uint8_t a_ctx_render(a_ctx* ctx, int16_t* dst, uint32_t frames) {
+  if (!ctx->render) {
+    ASTERA_FUNC_DBG("context isn't a loopback context.\n");
+    return 0;
+  }
+
+  while (frames) {
+    uint32_t chunk = frames;
+
+    // Split the mix at scheduled starts so they land on their sample
+    for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+      a_sfx* sfx = &ctx->sfx[i];
+
+      if (sfx->scheduled && !_a_sfx_held(ctx, sfx) &&
+          sfx->start > ctx->render_frames &&
+          sfx->start - ctx->render_frames < chunk) {
+        chunk = (uint32_t)(sfx->start - ctx->render_frames);
+      }
+    }
+
+    ctx->render(ctx->device, dst, (ALCsizei)chunk);
+
+    ctx->render_frames += chunk;
+    dst += chunk * ctx->render_channels;
+    frames -= chunk;
+
+    for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+      a_sfx* sfx = &ctx->sfx[i];
+
+      if (sfx->scheduled && !_a_sfx_held(ctx, sfx) &&
+          sfx->start <= ctx->render_frames) {
+        _a_sfx_schedule(ctx, sfx, ctx->render_frames);
+      }
+    }
+  }
+
+  ctx->render_clock = ((time_s)ctx->render_frames / ctx->render_rate) * 1000.0;
+
+  return 1;
+}
+
+uint8_t a_ctx_destroy(a_ctx* ctx) {
+  if (!ctx) {
+    ASTERA_FUNC_DBG("no context passed to destroy.\n");
+    return 0;
+  }
+
+  if (ctx->stream) {
+    a_ctx_stop_stream(ctx);
+  }
+
+  if (ctx->decoder) {
+    s_atomic_store(&ctx->decode_run, 0);
+    s_thread_join(ctx->decoder);
+  }
+
+  for (uint16_t i = 0; i < ctx->buffer_capacity; ++i) {
+    free(ctx->buffers[i].ogg);
+    free(ctx->buffers[i].pcm);
+  }
+
+  // Layers unlink the sfx & songs in them, so they go before either
+  if (ctx->layer_capacity && ctx->layers) {
+    for (uint16_t i = 0; i < ctx->layer_capacity; ++i) {
+      _a_layer_destroy(ctx, &ctx->layers[i]);
+    }
+
+    free(ctx->layers);
+  }
+
+  for (uint16_t i = 0; i < ctx->song_capacity; ++i) {
+    a_song* song = &ctx->songs[i];
+
+    _a_song_close(song);
+
+    if (song->buffers)
+      free(song->buffers);
+
+    if (song->buffer_sizes)
+      free(song->buffer_sizes);
+
+    free(song->pcm);
+    free(song->pcm16);
+    free(song->ring);
+  }
+
+  if (ctx->fx_capacity && ctx->fx_slots) {
+    free(ctx->fx_slots);
+  }
+
+  if (ctx->filter_capacity && ctx->filter_slots) {
+    free(ctx->filter_slots);
+  }
+
+  if (ctx->buffers)
+    free(ctx->buffers);
+
+  if (ctx->buffer_names)
+    free(ctx->buffer_names);
+
+  if (ctx->songs)
+    free(ctx->songs);
+
+  if (ctx->song_names)
+    free(ctx->song_names);
+
+  for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+    if (ctx->sfx[i].source) {
+      _a_sfx_unbind(ctx, &ctx->sfx[i]);
+    }
+  }
+
+  if (ctx->voice_free) {
+    alDeleteSources(ctx->voice_free_count, ctx->voice_free);
+    free(ctx->voice_free);
+  }
+
+  if (ctx->voice_batch)
+    free(ctx->voice_batch);
+
+  if (ctx->sfx)
+    free(ctx->sfx);
+
+  if (ctx->cmds)
+    free(ctx->cmds);
+
+  if (ctx->cmd_sequences)
+    free((void*)ctx->cmd_sequences);
+
+  alcCloseDevice(ctx->device);
+  alcDestroyContext(ctx->context);
+
+  free(ctx);
+
+  return 1;
+}
+
+void a_song_update_decode(a_ctx* ctx, a_song* song) {
+  ALenum state;
+  ALint  proc;
+
+  alGetSourcei(song->source, AL_SOURCE_STATE, &state);
+  alGetSourcei(song->source, AL_BUFFERS_PROCESSED, &proc);
+
+  float sec_offset;
+  alGetSourcef(song->source, AL_SEC_OFFSET, &sec_offset);
+
+  song->delta     = song->curr + (sec_offset * 1000.f);
+  song->req->time = song->delta;
+
+  ctx->al_calls += 3;
+
+  uint8_t ended = !song->req->loop && _a_song_tell(song) >= song->sample_count;
+  _a_song_depth(song, proc, ended);
+
+  // Stopped with nothing left to queue, it's played out to its end
+  if (state == AL_STOPPED && ended) {
+    song->playing    = 0;
+    song->req->state = AL_STOPPED;
+    return;
+  }
+
+  if (proc > 0) {
+    uint32_t al_error;
+    uint32_t buffer, offset = _a_song_tell(song);
+
+    _a_song_prefetch(song);
+
+    if (offset >= song->sample_count) {
+      if (song->req->loop) {
+        _a_song_seek(song, 0);
+      } else {
+        return;
+      }
+    }
+
+    for (int32_t p = 0; p < proc; ++p) {
+      alSourceUnqueueBuffers(song->source, 1, &buffer);
+
+      for (uint8_t i = 0; i < song->buffer_count; ++i) {
+        if (song->buffers[i] != buffer) {
+          continue;
+        }
+
+        song->curr += ((time_s)song->buffer_sizes[i] / song->info.sample_rate) *
+                      1000.0;
+
+        uint32_t samples      = _a_song_decode(song);
+        song->buffer_sizes[i] = samples / song->channels;
+
+        _a_song_upload(song, buffer, samples);
+        break;
+      }
+
+      alSourceQueueBuffers(song->source, 1, &buffer);
+      ctx->al_calls += 3;
+
+      if ((al_error = alGetError()) == AL_INVALID_VALUE) {
+        ASTERA_FUNC_DBG("AL Error %i\n", al_error);
+      }
+    }
+  }
+
+  // The queue ran dry before we refilled it, every buffer is fresh again
+  if (proc == song->buffer_count &&
+      (state == AL_PLAYING || state == AL_STOPPED)) {
+    alSourcePlay(song->source);
+    song->req->state = AL_PLAYING;
+  }
+}
+
+// Hold source & listener changes so a frame's worth applies at once
+static void _a_ctx_defer(a_ctx* ctx) {
+  if (ctx->defer_updates) {
+    ctx->defer_updates();
+  } else {
+    alcSuspendContext(ctx->context);
+  }
+}
+
+static void _a_ctx_process(a_ctx* ctx) {
+  if (ctx->process_updates) {
+    ctx->process_updates();
+  } else {
+    alcProcessContext(ctx->context);
+  }
+}
+
+// Take the counters since the last update into the context's stats
+static void _a_ctx_stats(a_ctx* ctx, time_s start) {
+  a_stats* stats = &ctx->stats;
+
+  stats->voices         = 0;
+  stats->virtual_voices = 0;
+  stats->culled         = 0;
+
+  for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+    a_sfx* sfx = &ctx->sfx[i];
+
+    if (!sfx->buffer) {
+      continue;
+    }
+
+    if (sfx->source) {
+      ++stats->voices;
+    } else {
+      ++stats->virtual_voices;
+      stats->culled += sfx->culled;
+    }
+  }
+
+  stats->fx_used         = ctx->fx_count;
+  stats->fx_capacity     = ctx->fx_capacity;
+  stats->filters_used    = ctx->filter_count;
+  stats->filter_capacity = ctx->filter_capacity;
+
+  stats->al_calls = ctx->al_calls;
+  ctx->al_calls   = 0;
+
+  // The streaming thread adds to the decode counters as it goes
+  _a_song_lock(ctx);
+
+  stats->decode_time        = ctx->decode_time;
+  stats->dsp_time           = ctx->dsp_time;
+  stats->samples_decoded    = ctx->decode_samples;
+  stats->underruns          = ctx->underruns;
+  stats->last_underrun      = ctx->last_underrun;
+  stats->last_underrun_song = ctx->last_underrun_song;
+
+  ctx->decode_time    = 0;
+  ctx->dsp_time       = 0;
+  ctx->decode_samples = 0;
+
+  _a_song_unlock(ctx);
+
+  stats->update_time = s_get_time() - start;
+}
+
+// Stop what was played on rolled back frames & not played again since
+static void _a_ctx_orphans(a_ctx* ctx) {
+  for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+    if (ctx->sfx[i].orphan) {
+      _a_sfx_release(ctx, &ctx->sfx[i]);
+    }
+  }
+
+  for (uint16_t i = 0; i < ctx->song_high; ++i) {
+    if (ctx->songs[i].orphan) {
+      ctx->songs[i].orphan = 0;
+      a_song_stop(ctx, ctx->songs[i].id);
+    }
+  }
+
+  ctx->orphans = 0;
+}
+
+void a_ctx_update(a_ctx* ctx) {
+  time_s update_start = s_get_time();
+
+  _a_ctx_defer(ctx);
+  _a_cmd_drain(ctx);
+
+  if (ctx->orphans) {
+    _a_ctx_orphans(ctx);
+  }
+
+  // Loopback contexts run off of rendered time to stay deterministic
+  time_s now   = (ctx->render) ? ctx->render_clock : s_get_time();
+  time_s delta = (now - ctx->last_update) / MS_TO_SEC;
+  ctx->last_update = now;
+
+  for (uint16_t i = 0; i < ctx->song_capacity; ++i) {
+    a_song* song = &ctx->songs[i];
+    if (!song)
+      continue;
+
+    if (song->req) {
+      if (song->req->stop) {
+        a_song_stop(ctx, song->id);
+        continue;
+      }
+
+      if (song->req->destroy) {
+        a_song_destroy(ctx, song->id);
+        continue;
+      }
+
+      if (song->starting) {
+        if (s_atomic_load(&song->priming)) {
+          // The streaming thread primes songs while it's running
+          if (!ctx->stream) {
+            a_profile profile = _a_profile_begin(song);
+            _a_song_prime_next(song);
+            _a_profile_end(ctx, song, &profile);
+          }
+          continue;
+        }
+
+        _a_song_begin(ctx, song, now);
+      }
+
+      if (song->fading && !_a_song_fade(ctx, song, now)) {
+        continue;
+      }
+
+      // The streaming thread owns decoding & the song's state
+      if (ctx->stream) {
+        if (song->playing) {
+          _a_song_apply(ctx, song);
+        }
+        continue;
+      }
+
+      ALenum state;
+      alGetSourcei(song->source, AL_SOURCE_STATE, &state);
+      ++ctx->al_calls;
+
+      song->req->state = state;
+
+      // A starved source reads stopped, it's restarted once it's refilled
+      if (state == AL_PLAYING || (state == AL_STOPPED && song->playing)) {
+        if (song->sample_count == song->sample_offset) {
+          if (song->req->loop) {
+            _a_song_reset(song);
+          } else {
+            alSourceStop(song->source);
+            song->playing    = 0;
+            song->req->state = AL_STOPPED;
+            continue;
+          }
+        }
+
+        a_profile profile = _a_profile_begin(song);
+        a_song_update_decode(ctx, song);
+        _a_profile_end(ctx, song, &profile);
+
+        _a_song_apply(ctx, song);
+      }
+    }
+  }
+
+  uint64_t now_sample = a_ctx_get_sample(ctx);
+
+  // Buffers sfx are waiting on go up right away, the rest are spread out so
+  // a preload's worth of uploads doesn't land in one update
+  uint32_t uploaded = 0;
+  for (uint16_t i = 0; i < ctx->buffer_high; ++i) {
+    a_buf* buf = &ctx->buffers[i];
+
+    if (s_atomic_load(&buf->state) == A_BUF_DECODED &&
+        (buf->users || uploaded < ASTERA_AUDIO_UPLOAD_BUDGET)) {
+      uploaded += buf->length * buf->channels * sizeof(int16_t);
+      _a_buf_upload(ctx, buf);
+    }
+  }
+
+  for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+    a_sfx* sfx = &ctx->sfx[i];
+
+    if (!sfx->buffer || !sfx->req) {
+      continue;
+    }
+
+    if (sfx->req->stop) {
+      _a_sfx_release(ctx, sfx);
+      continue;
+    }
+
+    if (sfx->scheduled) {
+      if (!sfx->start_song || _a_sfx_follow(ctx, sfx, now_sample)) {
+        _a_sfx_schedule(ctx, sfx, now_sample);
+      }
+      continue;
+    }
+
+    if (sfx->source) {
+      ALenum state;
+      alGetSourcei(sfx->source, AL_SOURCE_STATE, &state);
+      ++ctx->al_calls;
+
+      if (state == AL_STOPPED) {
+        _a_sfx_release(ctx, sfx);
+        continue;
+      }
+
+      _a_sfx_apply(ctx, sfx);
+
+      // The offset going backwards means the source wrapped around
+      float sec_offset;
+      alGetSourcef(sfx->source, AL_SEC_OFFSET, &sec_offset);
+      ++ctx->al_calls;
+      if (sfx->req->loop && sec_offset < sfx->req->time) {
+        ++sfx->req->loop_count;
+      }
+
+      sfx->req->time  = sec_offset;
+      sfx->req->state = state;
+    } else {
+      a_buf*   buf   = &ctx->buffers[sfx->buffer - 1];
+      uint32_t state = s_atomic_load(&buf->state);
+
+      if (state == A_BUF_FAILED) {
+        _a_sfx_release(ctx, sfx);
+        continue;
+      }
+
+      // Virtual, keep time as if it were playing (held at 0 until decoded)
+      if (!sfx->paused && state == A_BUF_READY) {
+        // Preloaded buffers only know their length once they're loaded
+        sfx->length     = buf->length;
+        time_s duration = (time_s)sfx->length / buf->sample_rate;
+
+        sfx->req->time += delta * sfx->pitch;
+
+        if (sfx->req->time >= duration) {
+          if (sfx->req->loop && duration > 0) {
+            sfx->req->time = fmod(sfx->req->time, duration);
+            ++sfx->req->loop_count;
+          } else {
+            _a_sfx_release(ctx, sfx);
+            continue;
+          }
+        }
+      }
+    }
+
+    // Distant loops swap their effect sends out while they keep playing
+    if (_a_sfx_cull(ctx, sfx) && sfx->source) {
+      _a_source_fx(ctx, sfx->source, sfx->req, sfx->lod);
+    }
+
+    sfx->audibility = _a_sfx_audibility(ctx, sfx);
+
+    // Out of range or too quiet, the sfx goes virtual & keeps its time
+    if (sfx->source && sfx->audibility < ASTERA_AUDIO_MIN_AUDIBILITY) {
+      _a_sfx_unbind(ctx, sfx);
+    }
+  }
+
+  _a_voice_balance(ctx);
+
+  _a_ctx_process(ctx);
+
+  _a_ctx_stats(ctx, update_start);
+}
+
+// xorshift32, the context's own so variations don't touch rand()'s state
+static uint32_t _a_rand(a_ctx* ctx) {
+  uint32_t x = ctx->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  ctx->rng = x;
+  return x;
+}
+
+// returns: a random value in [-1, 1)
+static float _a_randf(a_ctx* ctx) {
+  return (float)(_a_rand(ctx) >> 8) * (2.f / 16777216.f) - 1.f;
+}
+
+// Pick a buffer out of a group, skipping the one picked last
+// returns: the buffer ID, 0 = no group with that ID
+static uint16_t _a_group_pick(a_ctx* ctx, uint16_t group_id) {
+  if (!group_id || group_id > ASTERA_AUDIO_GROUPS) {
+    return 0;
+  }
+
+  a_group* group = &ctx->groups[group_id - 1];
+
+  if (!group->name || !group->count) {
+    return 0;
+  }
+
+  uint16_t pick = 0;
+
+  if (group->count > 1) {
+    uint16_t skip = (group->last < group->count);
+
+    pick = (uint16_t)(_a_rand(ctx) % (group->count - skip));
+    if (skip && pick >= group->last) {
+      ++pick;
+    }
+  }
+
+  group->last = pick;
+  return group->bufs[pick];
+}
+
+// Take an sfx slot for a buffer, leaving it virtual
+// from - the slot to start looking for a free one at
+static a_sfx* _a_sfx_start(a_ctx* ctx, uint16_t layer, uint16_t buf_id,
+                           a_req* req, uint16_t from) {
+  a_layer* _layer = 0;
+  if (layer) {
+    _layer = _a_get_layer(ctx, layer);
+    if (!_layer) {
+      ASTERA_FUNC_DBG("no layer with ID %i\n", layer);
+      return 0;
+    }
+
+    if (_layer->sfx_count >= _layer->sfx_capacity) {
+      ASTERA_FUNC_DBG("no free slots in layer\n");
+      return 0;
+    }
+  }
+
+  // Variations are picked here so one buffer can serve all of them
+  if (req->group) {
+    buf_id = _a_group_pick(ctx, req->group);
+
+    if (!buf_id) {
+      ASTERA_FUNC_DBG("no group with ID %i\n", req->group);
+      return 0;
+    }
+  }
+
+  a_buf* buf = a_buf_get_id(ctx, buf_id);
+  if (!buf || !buf->buf) {
+    ASTERA_FUNC_DBG("unable to find %i\n", buf_id);
+    return 0;
+  }
+
+  if (s_atomic_load(&buf->state) == A_BUF_FAILED) {
+    ASTERA_FUNC_DBG("buffer %i failed to decode.\n", buf_id);
+    return 0;
+  }
+
+  a_sfx* slot = 0;
+  for (uint16_t i = from; i < ctx->sfx_capacity; ++i) {
+    if (!ctx->sfx[i].buffer) {
+      slot = &ctx->sfx[i];
+      break;
+    }
+  }
+
+  if (!slot) {
+    // Every slot is taken, drop the least important sfx if this one matters
+    // more than it does
+    a_sfx incoming = {.req = req};
+    if (_a_range_ratio(ctx, req->position, req->range) <= 1.f) {
+      incoming.audibility = req->gain * ((_layer) ? _layer->gain : 1.f) *
+                            _a_attenuation(ctx, req->position);
+    }
+
+    for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+      a_sfx* sfx = &ctx->sfx[i];
+      if (sfx->req && (!slot || _a_sfx_less(sfx, slot, 1.f))) {
+        slot = sfx;
+      }
+    }
+
+    if (!slot || !_a_sfx_less(slot, &incoming, 1.f)) {
+      ASTERA_FUNC_DBG("no free sfx slots.\n");
+      return 0;
+    }
+
+    _a_sfx_release(ctx, slot);
+  }
+
+  slot->buffer = buf->id;
+  slot->length = buf->length;
+  slot->req    = req;
+  slot->paused = 0;
+  slot->culled = 0;
+  slot->lod    = 0;
+
+  // Within an octave either way, & never below silence
+  float pitch      = 1.f + req->pitch_range * _a_randf(ctx);
+  float gain_scale = 1.f + req->gain_range * _a_randf(ctx);
 
-    for (uint16_t i = 0; i < max_songs; ++i) {
-      ctx->songs[i].id = i + 1;
-      alGenSources(1, &ctx->songs[i].source);
-      ctx->songs[i].req = 0;
-    }
+  slot->pitch      = (pitch < 0.5f) ? 0.5f : (pitch > 2.f) ? 2.f : pitch;
+  slot->gain_scale = (gain_scale < 0.f) ? 0.f : gain_scale;
+
+  _a_sfx_cull(ctx, slot);
+
+  req->time  = 0;
+  req->valid = 1;
+  req->state = AL_PLAYING;
+
+  ++ctx->sfx_count;
+  ++buf->users;
+  buf->last_use = ++ctx->buf_clock;
+
+  // OGG buffers decode on first play, until then the sfx waits virtually
+  if (buf->ogg) {
+    _a_buf_request(ctx, buf);
   }
 
-  ctx->buffer_count    = 0;
-  ctx->buffer_capacity = max_buffers;
-  ctx->buffer_high     = 0;
+  if (layer != 0) {
+    _a_layer_add(ctx, _layer, slot->id, 1);
+  }
 
-  if (max_buffers) {
-    ctx->buffers      = (a_buf*)calloc(max_buffers, sizeof(a_buf));
-    ctx->buffer_names = (const char**)calloc(max_buffers, sizeof(char*));
+  return slot;
+}
 
-    for (uint16_t i = 0; i < max_buffers; ++i) {
-      ctx->buffers[i].id = i + 1;
-    }
+// A play re-simulated after a restore picks up the sfx it started the first
+// time, rather than starting it over
+// returns: the sfx picked up, 0 = none
+static a_sfx* _a_sfx_adopt(a_ctx* ctx, uint16_t buf_id, a_req* req) {
+  if (!ctx->orphans) {
+    return 0;
   }
 
-  ctx->sfx_capacity = max_sfx;
-  ctx->sfx_count    = 0;
+  for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+    a_sfx* sfx = &ctx->sfx[i];
 
-  if (max_sfx) {
-    ctx->sfx = (a_sfx*)calloc(ctx->sfx_capacity, sizeof(a_sfx));
+    if (!sfx->orphan || sfx->req != req ||
+        (!req->group && sfx->buffer != buf_id)) {
+      continue;
+    }
 
-    for (uint16_t i = 0; i < max_sfx; ++i) {
-      ctx->sfx[i].id = i + 1;
-      alGenSources(1, &ctx->sfx[i].source);
-      ctx->sfx[i].req = 0;
+    // Roll what the first play did so later variations line up
+    if (req->group) {
+      _a_group_pick(ctx, req->group);
     }
+
+    _a_randf(ctx);
+    _a_randf(ctx);
+
+    sfx->orphan = 0;
+    return sfx;
   }
 
-  ctx->layer_count    = 0;
-  ctx->layer_capacity = layers;
+  return 0;
+}
 
-  if (layers) {
-    ctx->layers = (a_layer*)calloc(layers, sizeof(a_layer));
+uint16_t a_sfx_play(a_ctx* ctx, uint16_t layer, uint16_t buf_id, a_req* req) {
+  a_sfx* sfx = _a_sfx_adopt(ctx, buf_id, req);
+  if (sfx) {
+    return sfx->id;
+  }
 
-    for (uint16_t i = 0; i < layers; ++i) {
-      ctx->layers[i].gain = 1.f;
+  sfx = _a_sfx_start(ctx, layer, buf_id, req, 0);
+  if (!sfx) {
+    return 0;
+  }
+
+  // Starts out virtual if it's inaudible or nothing's less important
+  sfx->audibility = _a_sfx_audibility(ctx, sfx);
+  _a_sfx_claim(ctx, sfx);
+
+  return sfx->id;
+}
+
+uint16_t a_sfx_play_many(a_ctx* ctx, uint16_t layer, const uint16_t* buf_ids,
+                         a_req* reqs, uint16_t count, uint16_t* ids) {
+  if (!buf_ids || !reqs || !count) {
+    ASTERA_FUNC_DBG("Invalid parameters passed\n");
+    return 0;
+  }
+
+  // Everything's set up in one deferred batch & started with one call
+  _a_ctx_defer(ctx);
+
+  ctx->batching          = 1;
+  ctx->voice_batch_count = 0;
+
+  uint16_t started = 0, from = 0;
+
+  for (uint16_t i = 0; i < count; ++i) {
+    a_sfx* sfx = _a_sfx_adopt(ctx, buf_ids[i], &reqs[i]);
+
+    if (sfx) {
+      if (ids) {
+        ids[i] = sfx->id;
+      }
+
+      ++started;
+      continue;
+    }
+
+    sfx = _a_sfx_start(ctx, layer, buf_ids[i], &reqs[i], from);
+
+    if (ids) {
+      ids[i] = (sfx) ? sfx->id : 0;
+    }
+
+    if (!sfx) {
+      continue;
     }
+
+    // Every slot before this one is taken now
+    from = sfx->id;
+
+    sfx->audibility = _a_sfx_audibility(ctx, sfx);
+    _a_sfx_claim(ctx, sfx);
+
+    ++started;
   }
 
-  ctx->allow = 1;
-  return ctx;
+  ctx->batching = 0;
+
+  if (ctx->voice_batch_count) {
+    alSourcePlayv(ctx->voice_batch_count, ctx->voice_batch);
+    ++ctx->al_calls;
+  }
+
+  _a_ctx_process(ctx);
+
+  return started;
 }
 
-uint8_t a_ctx_destroy(a_ctx* ctx) {
-  if (!ctx) {
-    ASTERA_FUNC_DBG("no context passed to destroy.\n");
+uint64_t a_ctx_get_sample(a_ctx* ctx) {
+  if (ctx->render) {
+    return ctx->render_frames;
+  }
+
+  if (ctx->device_clock) {
+    int64_t ns = 0;
+    ctx->device_clock(ctx->device, ALC_DEVICE_CLOCK_SOFT, 1, &ns);
+    return _a_ns_to_sample(ns, ctx->mix_rate);
+  }
+
+  return (uint64_t)((s_get_time() - ctx->clock_start) / MS_TO_SEC *
+                    ctx->mix_rate);
+}
+
+uint16_t a_sfx_play_at(a_ctx* ctx, uint16_t layer, uint16_t buf_id,
+                       a_req* req, uint64_t sample) {
+  a_sfx* sfx = _a_sfx_start(ctx, layer, buf_id, req, 0);
+  if (!sfx) {
     return 0;
   }
 
-  for (uint16_t i = 0; i < ctx->song_capacity; ++i) {
-    a_song* song = &ctx->songs[i];
+  sfx->scheduled = 1;
+  sfx->start     = sample;
+  req->state     = AL_INITIAL;
 
-    if (song->vorbis)
-      stb_vorbis_close(song->vorbis);
+  _a_sfx_schedule(ctx, sfx, a_ctx_get_sample(ctx));
 
-    if (song->buffers)
-      free(song->buffers);
+  return sfx->id;
+}
 
-    if (song->buffer_sizes)
-      free(song->buffer_sizes);
+uint16_t a_sfx_play_on_song(a_ctx* ctx, uint16_t layer, uint16_t buf_id,
+                            a_req* req, uint16_t song_id, time_s song_time) {
+  if (!song_id || song_id > ctx->song_high || !ctx->songs[song_id - 1].req) {
+    ASTERA_FUNC_DBG("song %i isn't playing.\n", song_id);
+    return 0;
   }
 
-  if (ctx->fx_capacity && ctx->fx_slots) {
-    free(ctx->fx_slots);
+  a_sfx* sfx = _a_sfx_start(ctx, layer, buf_id, req, 0);
+  if (!sfx) {
+    return 0;
   }
 
-  if (ctx->filter_capacity && ctx->filter_slots) {
-    free(ctx->filter_slots);
+  sfx->scheduled  = 1;
+  sfx->start_song = song_id;
+  sfx->start_time = song_time;
+  req->state      = AL_INITIAL;
+
+  uint64_t now = a_ctx_get_sample(ctx);
+  if (_a_sfx_follow(ctx, sfx, now)) {
+    _a_sfx_schedule(ctx, sfx, now);
   }
 
-  if (ctx->buffers)
-    free(ctx->buffers);
+  return sfx->id;
+}
 
-  if (ctx->buffer_names)
-    free(ctx->buffer_names);
+uint8_t a_sfx_stop(a_ctx* ctx, uint16_t sfx_id) {
+  a_sfx* sfx = &ctx->sfx[sfx_id - 1];
 
-  if (ctx->songs)
-    free(ctx->songs);
+  if (!sfx->buffer) {
+    ASTERA_FUNC_DBG("no sfx playing in slot %i\n", sfx_id);
+    return 0;
+  }
 
-  if (ctx->song_names)
-    free(ctx->song_names);
+  _a_sfx_release(ctx, sfx);
 
-  if (ctx->sfx)
-    free(ctx->sfx);
+  return 1;
+}
 
-  if (ctx->pcm)
-    free(ctx->pcm);
+uint8_t a_sfx_pause(a_ctx* ctx, uint16_t sfx_id) {
+  a_sfx* sfx = &ctx->sfx[sfx_id - 1];
 
-  if (ctx->layer_capacity && ctx->layers) {
-    for (uint16_t i = 0; i < ctx->layer_capacity; ++i) {
-      _a_layer_destroy(&ctx->layers[i]);
-    }
+  if (sfx->buffer && sfx->source) {
+    alSourcePause(sfx->source);
+  }
 
-    free(ctx->layers);
+  sfx->paused = 1;
+
+  if (sfx->req) {
+    sfx->req->state = AL_PAUSED;
   }
 
-  alcCloseDevice(ctx->device);
-  alcDestroyContext(ctx->context);
+  return 1;
+}
 
-  free(ctx);
+uint8_t a_sfx_resume(a_ctx* ctx, uint16_t sfx_id) {
+  a_sfx* sfx = &ctx->sfx[sfx_id - 1];
+
+  if (sfx->buffer && sfx->source) {
+    alSourcePlay(sfx->source);
+  }
+
+  // Virtual sfx get a voice back on the next update if they're audible
+  sfx->paused = 0;
+
+  if (sfx->req) {
+    sfx->req->state = AL_PLAYING;
+  }
 
   return 1;
 }
 
-void a_song_update_decode(a_ctx* ctx, a_song* song) {
-  ALenum state;
-  ALint  proc;
+static void _a_snapshot_voice(a_snapshot_voice* entry, a_req* req,
+                              uint16_t id, uint16_t layer) {
+  *entry = (a_snapshot_voice){.req        = req,
+                              .values     = *req,
+                              .pitch      = 1.f,
+                              .gain_scale = 1.f,
+                              .id         = id,
+                              .layer      = layer};
+}
 
-  alGetSourcei(song->source, AL_SOURCE_STATE, &state);
-  alGetSourcei(song->source, AL_BUFFERS_PROCESSED, &proc);
+uint8_t a_ctx_snapshot(a_ctx* ctx, a_snapshot* snapshot) {
+  if (!ctx || !snapshot) {
+    ASTERA_FUNC_DBG("no context or snapshot passed.\n");
+    return 0;
+  }
 
-  float sec_offset;
-  alGetSourcef(song->source, AL_SEC_OFFSET, &sec_offset);
+  snapshot->time       = ctx->last_update;
+  snapshot->rng        = ctx->rng;
+  snapshot->sfx_count  = 0;
+  snapshot->song_count = 0;
 
-  song->delta     = song->curr + (sec_offset * 1000.f);
-  song->req->time = song->delta;
+  for (uint16_t i = 0; i < ASTERA_AUDIO_GROUPS; ++i) {
+    snapshot->group_last[i] = ctx->groups[i].last;
+  }
 
-  if (proc > 0) {
-    uint32_t al_error;
-    uint32_t buffer, offset = stb_vorbis_get_sample_offset(song->vorbis);
+  // Orphans haven't been played yet as far as the frame being saved knows
+  for (uint16_t i = 0; i < ctx->sfx_capacity &&
+                       snapshot->sfx_count < ASTERA_AUDIO_SNAPSHOT_SFX;
+       ++i) {
+    a_sfx* sfx = &ctx->sfx[i];
 
-    if (offset >= song->sample_count) {
-      if (song->req->loop) {
-        stb_vorbis_seek_start(song->vorbis);
-      } else {
-        return;
-      }
+    if (!sfx->buffer || !sfx->req || sfx->orphan) {
+      continue;
     }
 
-    for (uint8_t i = 0; i < proc; ++i) {
-      float buf_time =
-          (float)((float)song->buffer_sizes[0] / song->info.sample_rate) *
-          1000.f;
-      song->curr += buf_time;
+    a_snapshot_voice* entry = &snapshot->sfx[snapshot->sfx_count++];
+    _a_snapshot_voice(entry, sfx->req, sfx->id, sfx->link.layer);
 
-      memset(ctx->pcm, 0, ctx->pcm_length * sizeof(uint16_t));
-      uint32_t pcm_total_length = 0;
+    entry->pitch      = sfx->pitch;
+    entry->gain_scale = sfx->gain_scale;
+    entry->buffer     = sfx->buffer;
+    entry->paused     = sfx->paused;
+  }
 
-      alSourceUnqueueBuffers(song->source, 1, &buffer);
-      for (uint16_t p = 0; p < song->packets_per_buffer; ++p) {
-        uint32_t pcm_remaining = ctx->pcm_length - pcm_total_length;
+  for (uint16_t i = 0; i < ctx->song_high &&
+                       snapshot->song_count < ASTERA_AUDIO_SNAPSHOT_SONGS;
+       ++i) {
+    a_song* song = &ctx->songs[i];
 
-        if ((int)pcm_remaining < song->info.max_frame_size) {
-          break;
-        }
+    if (!song->req || !(song->playing || song->starting || song->paused) ||
+        song->orphan) {
+      continue;
+    }
 
-        if (pcm_remaining == 0) {
-          break;
-        }
+    a_snapshot_voice* entry = &snapshot->songs[snapshot->song_count++];
+    _a_snapshot_voice(entry, song->req, song->id, song->link.layer);
 
-        uint32_t num_samples = stb_vorbis_get_samples_short_interleaved(
-            song->vorbis, song->channels, ctx->pcm + pcm_total_length,
-            pcm_remaining);
+    entry->paused = song->paused;
+  }
 
-        if (num_samples > 0) {
-          int32_t sample_count = song->channels * num_samples;
-          pcm_total_length += sample_count;
-        }
+  return 1;
+}
 
-        for (uint8_t i = 0; i < song->buffer_count - 1; ++i) {
-          song->buffer_sizes[i] = song->buffer_sizes[i + 1];
-        }
+// Put a request's values back, leaving what's observed of playback alone
+static void _a_req_restore(a_req* dst, const a_req* src) {
+  a_req observed = *dst;
+  *dst           = *src;
 
-        song->buffer_sizes[song->buffer_count - 1] = num_samples;
-      }
+  dst->loop_count = observed.loop_count;
+  dst->time       = observed.time;
+  dst->valid      = observed.valid;
+  dst->state      = observed.state;
+}
 
-      stb_vorbis_info info = stb_vorbis_get_info(song->vorbis);
+// Bring back an sfx cut off since a snapshot, where it'd be by now
+static void _a_sfx_revive(a_ctx* ctx, const a_snapshot_voice* entry,
+                          time_s elapsed) {
+  a_buf* buf = a_buf_get_id(ctx, entry->buffer);
+  if (!buf || !buf->buf) {
+    return;
+  }
 
-      alBufferData(buffer, song->format, ctx->pcm,
-                   pcm_total_length * sizeof(uint16_t), info.sample_rate);
-      alSourceQueueBuffers(song->source, 1, &buffer);
+  time_s time = entry->values.time + elapsed * entry->pitch;
 
-      if ((al_error = alGetError()) == AL_INVALID_VALUE) {
-        ASTERA_FUNC_DBG("AL Error %i\n", al_error);
+  if (buf->length && buf->sample_rate) {
+    time_s duration = (time_s)buf->length / buf->sample_rate;
+
+    if (time >= duration) {
+      // It would've ended by now anyway
+      if (!entry->values.loop) {
+        return;
       }
+
+      time = fmod(time, duration);
     }
   }
 
-  if (proc == song->buffer_count && state == AL_PLAYING) {
-    alSourcePlay(song->source);
+  // Try for the same slot so the game's IDs still line up
+  uint16_t from = (entry->id <= ctx->sfx_capacity &&
+                   !ctx->sfx[entry->id - 1].buffer)
+                      ? entry->id - 1
+                      : 0;
+
+  // The variation was picked the first time, so don't pick again
+  a_req* req = entry->req;
+  *req       = entry->values;
+  req->group = 0;
+
+  a_sfx* sfx = _a_sfx_start(ctx, entry->layer, entry->buffer, req, from);
+
+  req->group = entry->values.group;
+
+  if (!sfx) {
+    return;
   }
+
+  sfx->pitch      = entry->pitch;
+  sfx->gain_scale = entry->gain_scale;
+  sfx->paused     = entry->paused;
+
+  req->time       = time;
+  req->loop_count = entry->values.loop_count;
+  req->state      = (sfx->paused) ? AL_PAUSED : AL_PLAYING;
+
+  sfx->audibility = _a_sfx_audibility(ctx, sfx);
+  _a_sfx_claim(ctx, sfx);
 }
 
-void a_ctx_update(a_ctx* ctx) {
-  float gain = 0.f;
+// Bring back a song stopped since a snapshot, where it'd be by now
+static void _a_song_revive(a_ctx* ctx, const a_snapshot_voice* entry,
+                           time_s elapsed) {
+  if (!entry->id || entry->id > ctx->song_high ||
+      !ctx->songs[entry->id - 1].buffers) {
+    return;
+  }
 
-  for (uint16_t i = 0; i < ctx->song_capacity; ++i) {
-    a_song* song = &ctx->songs[i];
-    if (!song)
-      continue;
+  a_song* song = &ctx->songs[entry->id - 1];
 
-    if (song->req) {
-      if (song->req->stop) {
-        a_song_stop(ctx, song->id);
-        continue;
-      }
+  // Paused songs haven't moved since
+  time_s time = entry->values.time;
+  if (!entry->paused) {
+    time += elapsed * MS_TO_SEC;
+  }
 
-      if (song->req->destroy) {
-        a_song_destroy(ctx, song->id);
-        continue;
-      }
+  if (song->length > 0 && time >= song->length) {
+    // It would've ended by now anyway
+    if (!entry->values.loop) {
+      return;
+    }
 
-      ALenum state;
-      alGetSourcei(song->source, AL_SOURCE_STATE, &state);
+    time = fmod(time, song->length);
+  }
 
-      song->req->state = state;
+  _a_song_lock(ctx);
+  _a_song_cue(song, time);
+  _a_song_unlock(ctx);
 
-      if (state == AL_PLAYING) {
-        if (song->sample_count == song->sample_offset) {
-          if (song->req->loop) {
-            _a_song_reset(ctx, song);
-          } else {
-            alSourceStop(song->source);
-            song->req->state = AL_STOPPED;
-            continue;
-          }
-        }
+  *entry->req = entry->values;
+  a_song_play(ctx, entry->layer, entry->id, entry->req);
 
-        a_song_update_decode(ctx, song);
-        gain = _a_get_gain(ctx, song->id, 0);
-        alSourcef(song->source, AL_GAIN, gain);
-        alSource3f(song->source, AL_POSITION, song->req->position[0],
-                   song->req->position[1], song->req->position[2]);
-        alSource3f(song->source, AL_VELOCITY, song->req->velocity[0],
-                   song->req->velocity[1], song->req->velocity[2]);
-        alSourcef(song->source, AL_MAX_DISTANCE, song->req->range);
-      }
+  if (entry->paused) {
+    a_song_pause(ctx, entry->id);
+  }
+}
+
+// returns: the index of the entry for id & req, -1 = none
+static int32_t _a_snapshot_find(const a_snapshot_voice* entries,
+                                uint16_t count, uint16_t id, a_req* req) {
+  for (uint16_t i = 0; i < count; ++i) {
+    if (entries[i].id == id && entries[i].req == req) {
+      return i;
     }
   }
 
+  return -1;
+}
+
+uint8_t a_ctx_restore(a_ctx* ctx, const a_snapshot* snapshot) {
+  if (!ctx || !snapshot) {
+    ASTERA_FUNC_DBG("no context or snapshot passed.\n");
+    return 0;
+  }
+
+  time_s now     = (ctx->render) ? ctx->render_clock : s_get_time();
+  time_s elapsed = (now - snapshot->time) / MS_TO_SEC;
+
+  uint8_t kept[ASTERA_AUDIO_SNAPSHOT_SFX]        = {0};
+  uint8_t kept_songs[ASTERA_AUDIO_SNAPSHOT_SONGS] = {0};
+
+  // What's in both keeps playing, the rest was played on rolled back frames
   for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
     a_sfx* sfx = &ctx->sfx[i];
 
-    if (!sfx)
+    if (!sfx->buffer || !sfx->req) {
+      continue;
+    }
+
+    int32_t entry = _a_snapshot_find(snapshot->sfx, snapshot->sfx_count,
+                                     sfx->id, sfx->req);
+
+    if (entry < 0 || snapshot->sfx[entry].buffer != sfx->buffer) {
+      sfx->orphan  = 1;
+      ctx->orphans = 1;
       continue;
+    }
+
+    const a_snapshot_voice* voice = &snapshot->sfx[entry];
+
+    kept[entry] = 1;
+    sfx->orphan = 0;
+    _a_req_restore(sfx->req, &voice->values);
+
+    if (voice->paused != sfx->paused) {
+      if (voice->paused) {
+        a_sfx_pause(ctx, sfx->id);
+      } else {
+        a_sfx_resume(ctx, sfx->id);
+      }
+    }
+  }
+
+  for (uint16_t i = 0; i < ctx->song_high; ++i) {
+    a_song* song = &ctx->songs[i];
 
-    if (!sfx->buffer || !sfx->req || !sfx->source) {
+    if (!song->req || !(song->playing || song->starting || song->paused)) {
       continue;
     }
 
-    ALenum state;
-    alGetSourcei(sfx->source, AL_SOURCE_STATE, &state);
+    int32_t entry = _a_snapshot_find(snapshot->songs, snapshot->song_count,
+                                     song->id, song->req);
 
-    int8_t remove =
-        (state != AL_PLAYING && sfx->req->time > 0.f) || sfx->req->stop;
+    if (entry < 0) {
+      song->orphan = 1;
+      ctx->orphans = 1;
+      continue;
+    }
 
-    if (remove) {
-      for (uint16_t j = 0; j < ctx->layer_capacity; ++j) {
-        _a_layer_remove(&ctx->layers[j], sfx->id, 1);
-      }
+    const a_snapshot_voice* voice = &snapshot->songs[entry];
 
-      --ctx->sfx_count;
+    kept_songs[entry] = 1;
+    song->orphan      = 0;
+    _a_req_restore(song->req, &voice->values);
 
-      if (sfx->req) {
-        sfx->req->valid = 0;
-        sfx->req->state = AL_STOPPED;
+    if (voice->paused != song->paused) {
+      if (voice->paused) {
+        a_song_pause(ctx, song->id);
+      } else {
+        a_song_resume(ctx, song->id);
       }
-
-      sfx->req    = 0;
-      sfx->buffer = 0;
-      sfx->length = 0;
-
-      alSourceStop(sfx->source);
-      alSourcei(sfx->source, AL_BUFFER, 0);
-
-      continue;
     }
+  }
 
-    gain = _a_get_gain(ctx, sfx->id, 1);
-    alSourcef((ALuint)sfx->source, AL_GAIN, gain);
-    alSource3f((ALuint)sfx->source, AL_POSITION, sfx->req->position[0],
-               sfx->req->position[1], sfx->req->position[2]);
-    alSource3f((ALuint)sfx->source, AL_VELOCITY, sfx->req->velocity[0],
-               sfx->req->velocity[1], sfx->req->velocity[2]);
-    alSourcef((ALuint)sfx->source, AL_MAX_DISTANCE, sfx->req->range);
-    alSourcei((ALuint)sfx->source, AL_LOOPING, sfx->req->loop);
+  // Whatever was cut off since comes back in
+  for (uint16_t i = 0; i < snapshot->sfx_count; ++i) {
+    if (!kept[i]) {
+      _a_sfx_revive(ctx, &snapshot->sfx[i], elapsed);
+    }
+  }
 
-    ALint sample_offset;
-    alGetSourcei(sfx->source, AL_SAMPLE_OFFSET, &sample_offset);
-    if ((uint32_t)sample_offset >= sfx->length) {
-      if (sfx->req->loop)
-        ++sfx->req->loop_count;
+  for (uint16_t i = 0; i < snapshot->song_count; ++i) {
+    if (!kept_songs[i]) {
+      _a_song_revive(ctx, &snapshot->songs[i], elapsed);
     }
+  }
 
-    alGetSourcef((ALuint)sfx->source, AL_SEC_OFFSET, (ALfloat*)&sfx->req->time);
+  // Re-simulated plays pick the same variations they did the first time
+  ctx->rng = snapshot->rng;
+  for (uint16_t i = 0; i < ASTERA_AUDIO_GROUPS; ++i) {
+    ctx->groups[i].last = snapshot->group_last[i];
   }
+
+  return 1;
 }
 
-uint16_t a_sfx_play(a_ctx* ctx, uint16_t layer, uint16_t buf_id, a_req* req) {
-  if (ctx->sfx_count == ctx->sfx_capacity - 1) {
-    ASTERA_FUNC_DBG("no free sfx slots.\n");
-    return 0;
-  }
+// Find a free song slot & name it
+static a_song* _a_song_slot(a_ctx* ctx, const char* name, int8_t* new_high) {
+  *new_high = 0;
 
-  float gain = req->gain;
-  if (layer) {
-    a_layer* _layer = _a_get_layer(ctx, layer);
-    gain *= _layer->gain;
-    if (_layer->sfx_count == _layer->sfx_capacity - 1) {
-      ASTERA_FUNC_DBG("no free slots in layer\n");
-      return 0;
+  for (uint16_t i = 0; i < ctx->song_high; ++i) {
+    if (!ctx->songs[i].buffers) {
+      ctx->song_names[i] = name;
+      return &ctx->songs[i];
     }
   }
 
-  a_buf* buf = a_buf_get_id(ctx, buf_id);
-  if (!buf) {
-    ASTERA_FUNC_DBG("unable to find %i\n", buf_id);
+  if (ctx->song_high >= ctx->song_capacity) {
+    ASTERA_FUNC_DBG("no free song slots.\n");
     return 0;
   }
 
-  a_sfx* slot = 0;
-  for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
-    if (ctx->sfx[i].source) {
-      uint32_t buffer_id;
-      alGetSourcei(ctx->sfx[i].source, AL_BUFFER, &buffer_id);
-      if (buffer_id == 0) {
-        slot = &ctx->sfx[i];
-        break;
-      }
-    } else {
-      slot = &ctx->sfx[i];
-      break;
-    }
-  }
+  ctx->song_names[ctx->song_high] = name;
+  *new_high                       = 1;
+  return &ctx->songs[ctx->song_high];
+}
 
-  if (!slot) {
-    ASTERA_FUNC_DBG("No slots open, really.\n");
-    return 0;
+// Allocate a song's buffers & queue up its start, once its decoder is open
+// samples - the max samples to decode per buffer
+static uint8_t _a_song_setup(a_ctx* ctx, a_song* song, uint32_t samples,
+                             uint8_t buffers) {
+  song->req      = 0;
+  song->curr     = 0.f;
+  song->channels = (song->info.channels > 2) ? 2 : song->info.channels;
+
+  if (ctx->float32) {
+    song->format = (song->channels > 1) ? AL_FORMAT_STEREO_FLOAT32
+                                        : AL_FORMAT_MONO_FLOAT32;
+  } else {
+    song->format = (song->channels > 1) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
   }
 
-  if (!slot->source) {
-    alGenSources(1, &slot->source);
+  // Whole frames only
+  if (ctx->pcm_length && samples > ctx->pcm_length) {
+    samples = ctx->pcm_length;
   }
+  song->buffer_samples = samples - (samples % song->channels);
 
-  alSourcei(slot->source, AL_BUFFER, buf->buf);
+  song->buffers      = (uint32_t*)malloc(sizeof(uint32_t) * buffers);
+  song->buffer_sizes = (uint32_t*)malloc(sizeof(uint32_t) * buffers);
+  song->buffer_count = buffers;
 
-#if !defined(ASTERA_AL_NO_FX)
-  // Apply fx
-  if (req->fx_count > 0) {
-    for (uint16_t i = 0; i < req->fx_count; ++i) {
-      // Make sure it's valid within the range of filters
-      if (req->fx[i] <= ctx->fx_capacity && req->fx[i] > 0) {
-        alSource3i(slot->source, AL_AUXILIARY_SEND_FILTER,
-                   (ALint)ctx->fx_slots[req->fx[i] - 1].slot_id, i, 0);
-      }
-    }
-  }
+  song->pcm   = (float*)malloc(sizeof(float) * song->buffer_samples);
+  song->pcm16 = (ctx->float32)
+                    ? 0
+                    : (int16_t*)malloc(sizeof(int16_t) * song->buffer_samples);
 
-  // Apply filters
-  if (req->filter_count > 0) {
-    for (uint16_t i = 0; i < req->filter_count; ++i) {
-      if (req->filters[i] <= ctx->filter_capacity && req->filters[i] > 0) {
-        alSourcei(slot->source, AL_DIRECT_FILTER,
-                  ctx->filter_slots[req->filters[i] - 1].al_id);
-      }
-    }
+  if (!song->buffer_samples || !song->buffers || !song->buffer_sizes ||
+      !song->pcm || (!ctx->float32 && !song->pcm16)) {
+    ASTERA_FUNC_DBG("unable to allocate song buffers\n");
+
+    free(song->buffers);
+    free(song->buffer_sizes);
+    free(song->pcm);
+    free(song->pcm16);
+
+    song->buffers      = 0;
+    song->buffer_sizes = 0;
+    song->pcm          = 0;
+    song->pcm16        = 0;
+
+    return 0;
   }
-#endif
 
-  slot->buffer = buf->id;
-  slot->length = buf->length;
-  slot->req    = req;
+  alGenBuffers(buffers, song->buffers);
+  alGenSources(1, &song->source);
 
-  uint32_t size;
-  alGetBufferi(buf->buf, AL_SIZE, (ALint*)&size);
+  for (uint8_t i = 0; i < buffers; ++i) {
+    _a_song_prime(song, i);
+  }
 
-  alSourcef(slot->source, AL_GAIN, req->gain);
-  alSource3f(slot->source, AL_POSITION, req->position[0], req->position[1],
-             req->position[2]);
-  alSource3f(slot->source, AL_VELOCITY, req->velocity[0], req->velocity[1],
-             req->velocity[2]);
-  alSourcei(slot->source, AL_LOOPING, req->loop);
+  song->ring    = 0;
+  song->playing = 0;
+  song->paused  = 0;
+  song->decoded = 0;
 
-  alSourcePlay(slot->source);
+  return 1;
+}
 
-  ++ctx->sfx_count;
+static uint16_t _a_song_create(a_ctx* ctx, unsigned char* data,
+                               uint32_t data_length, const char* name,
+                               uint16_t packets_per_buffer, uint8_t buffers,
+                               uint32_t max_buffer_size) {
+  int8_t  new_high;
+  a_song* song = _a_song_slot(ctx, name, &new_high);
 
-  if (layer != 0) {
-    _a_layer_add(_a_get_layer(ctx, layer), slot->id, 1);
+  if (!song) {
+    return 0;
   }
 
-  return slot->id;
-}
+  int32_t error;
 
-uint8_t a_sfx_stop(a_ctx* ctx, uint16_t sfx_id) {
-  a_sfx* sfx = &ctx->sfx[sfx_id - 1];
+  song->data   = data;
+  song->wav    = 0;
+  song->map    = 0;
+  song->vorbis = stb_vorbis_open_memory(data, data_length, &error, 0);
 
-  if (sfx->req) {
-    sfx->req->valid = 0;
-    sfx->req->state = AL_STOPPED;
+  if (!song->vorbis) {
+    song->data = 0;
+
+    ASTERA_FUNC_DBG("Unable to load vorbis, that sucks VORBIS Error: %i\n",
+                    error);
+
+    return 0;
   }
 
-  if (sfx->source && sfx->buffer) {
-    alSourceStop(sfx->source);
+  song->packets_per_buffer = packets_per_buffer;
+
+  song->info = stb_vorbis_get_info(song->vorbis);
+
+  if (max_buffer_size < song->info.max_frame_size) {
+    ASTERA_FUNC_DBG("max_buffer_size is smaller than the listed max "
+                    "frame size of this OGG file: %i vs %i\n",
+                    max_buffer_size, song->info.max_frame_size);
+
+    _a_song_close(song);
+    song->data = 0;
+
+    return 0;
   }
 
-  for (uint16_t i = 0; i < ctx->layer_capacity; ++i) {
-    _a_layer_remove(&ctx->layers[i], sfx->id, 1);
+  song->sample_count = stb_vorbis_stream_length_in_samples(song->vorbis);
+  song->length = stb_vorbis_stream_length_in_seconds(song->vorbis) * 1000.f;
+
+  // Only as many samples as the packets can fill
+  uint32_t channels = (song->info.channels > 2) ? 2 : song->info.channels;
+  uint32_t samples  = packets_per_buffer * song->info.max_frame_size * channels;
+  if (samples > max_buffer_size) {
+    samples = max_buffer_size;
   }
 
-  alSourcei(sfx->source, AL_BUFFER, 0);
+  if (!_a_song_setup(ctx, song, samples, buffers)) {
+    _a_song_close(song);
+    song->data = 0;
 
-  sfx->req    = 0;
-  sfx->buffer = 0;
-  sfx->length = 0;
+    return 0;
+  }
 
-  --ctx->sfx_count;
+  if (new_high)
+    ++ctx->song_high;
 
-  return 1;
-}
+  ++ctx->song_count;
 
-uint8_t a_sfx_pause(a_ctx* ctx, uint16_t sfx_id) {
-  a_sfx* sfx = &ctx->sfx[sfx_id - 1];
+  return song->id;
+}
 
-  if (sfx->buffer && sfx->source) {
-    alSourcePause(sfx->source);
+// Create a song streaming out of a WAV file, taking ownership of its file
+static uint16_t _a_song_create_wav(a_ctx* ctx, a_wav* source,
+                                   const char* name, uint8_t buffers,
+                                   uint32_t max_buffer_size) {
+  uint16_t channels    = 0;
+  uint32_t sample_rate = 0;
+  int8_t   new_high;
+  a_song*  song = 0;
+
+  if (_a_wav_parse(source, &channels, &sample_rate)) {
+    song = _a_song_slot(ctx, name, &new_high);
   }
 
-  if (sfx->req) {
-    sfx->req->state = AL_PAUSED;
+  a_wav* wav = (song) ? (a_wav*)malloc(sizeof(a_wav)) : 0;
+
+  if (!wav) {
+    if (source->file) {
+      fclose((FILE*)source->file);
+    }
+    return 0;
   }
 
-  return 1;
-}
+  memcpy(wav, source, sizeof(a_wav));
 
-uint8_t a_sfx_resume(a_ctx* ctx, uint16_t sfx_id) {
-  a_sfx* sfx = &ctx->sfx[sfx_id - 1];
+  song->data               = 0;
+  song->map                = 0;
+  song->vorbis             = 0;
+  song->wav                = wav;
+  song->packets_per_buffer = 0;
 
-  if (sfx->buffer && sfx->source) {
-    alSourcePlay(sfx->source);
+  memset(&song->info, 0, sizeof(stb_vorbis_info));
+  song->info.sample_rate = sample_rate;
+  song->info.channels    = channels;
+
+  song->sample_count = wav->pcm_length / ((wav->bits / 8) * channels);
+  song->length = ((time_s)song->sample_count / sample_rate) * 1000.0;
+
+  if (!_a_song_setup(ctx, song, max_buffer_size, buffers)) {
+    _a_song_close(song);
+    return 0;
   }
 
-  return 1;
+  if (new_high)
+    ++ctx->song_high;
+
+  ++ctx->song_count;
+
+  return song->id;
 }
 
 uint16_t a_song_create(a_ctx* ctx, unsigned char* data, uint32_t data_length,
@@ -1014,123 +4548,143 @@ uint16_t a_song_create(a_ctx* ctx, unsigned char* data, uint32_t data_length,
     return 0;
   }
 
-  a_song* song = 0;
+  _a_song_lock(ctx);
+  uint16_t song_id = _a_song_create(ctx, data, data_length, name,
+                                    packets_per_buffer, buffers,
+                                    max_buffer_size);
+  _a_song_unlock(ctx);
 
-  for (uint16_t i = 0; i < ctx->song_high; ++i) {
-    if (!ctx->songs[i].buffers) {
-      song               = &ctx->songs[i];
-      ctx->song_names[i] = name;
-    }
-  }
+  return song_id;
+}
 
-  int8_t new_high = 0;
-  if (!song && ctx->song_high < ctx->song_capacity) {
-    song                            = &ctx->songs[ctx->song_high];
-    ctx->song_names[ctx->song_high] = name;
-    new_high                        = 1;
-  } else {
+// Create a song decoding out of a mapping, taking ownership of it
+static uint16_t _a_song_create_map(a_ctx* ctx, s_map map, uint64_t offset,
+                                   uint32_t length, const char* name,
+                                   uint16_t packets_per_buffer,
+                                   uint8_t buffers, uint32_t max_buffer_size) {
+  if (!length || offset + length > s_map_size(map)) {
+    ASTERA_FUNC_DBG("song is outside of the mapped file.\n");
+    s_map_close(map);
     return 0;
   }
 
-  int32_t error;
+  unsigned char* data = (unsigned char*)s_map_data(map) + offset;
 
-  song->data   = data;
-  song->vorbis = stb_vorbis_open_memory(data, data_length, &error, 0);
-  song->req    = 0;
-  song->curr   = 0.f;
+  _a_song_lock(ctx);
+  uint16_t song_id = _a_song_create(ctx, data, length, name,
+                                    packets_per_buffer, buffers,
+                                    max_buffer_size);
 
-  if (!song->vorbis) {
-    song->data = 0;
-    song->req  = 0;
+  if (song_id) {
+    ctx->songs[song_id - 1].map = map;
+  }
+  _a_song_unlock(ctx);
 
-    ASTERA_FUNC_DBG("Unable to load vorbis, that sucks VORBIS Error: %i\n",
-                    error);
+  if (!song_id) {
+    s_map_close(map);
+  }
 
-    free(song->vorbis);
+  return song_id;
+}
 
+uint16_t a_song_create_file(a_ctx* ctx, const char* path, const char* name,
+                            uint16_t packets_per_buffer, uint8_t buffers,
+                            uint32_t max_buffer_size) {
+  if (!path || !packets_per_buffer || !buffers || !max_buffer_size) {
+    ASTERA_FUNC_DBG("Invalid parameters passed\n");
     return 0;
   }
 
-  song->packets_per_buffer = packets_per_buffer;
-
-  song->info = stb_vorbis_get_info(song->vorbis);
-
-  if (max_buffer_size < song->info.max_frame_size) {
-    ASTERA_FUNC_DBG("max_buffer_size is smaller than the listed max "
-                    "frame size of this OGG file: %i vs %i\n",
-                    max_buffer_size, song->info.max_frame_size);
-
-    free(song->vorbis);
-    song->data = 0;
-    song->req  = 0;
-
+  s_map map = s_map_open(path);
+  if (!map) {
     return 0;
   }
 
-  if (song->info.channels > 2) {
-    song->channels = 2;
+  if (s_map_size(map) > UINT32_MAX) {
+    ASTERA_FUNC_DBG("%s is too large to decode.\n", path);
+    s_map_close(map);
+    return 0;
   }
 
-  song->format   = (song->channels > 1) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
-  song->channels = song->info.channels;
-
-  song->buffers      = (uint32_t*)malloc(sizeof(uint32_t) * buffers);
-  song->buffer_sizes = (uint32_t*)malloc(sizeof(uint32_t) * buffers);
-  song->buffer_count = buffers;
-  song->sample_count = stb_vorbis_stream_length_in_samples(song->vorbis);
-  song->length = stb_vorbis_stream_length_in_seconds(song->vorbis) * 1000.f;
+  return _a_song_create_map(ctx, map, 0, (uint32_t)s_map_size(map), name,
+                            packets_per_buffer, buffers, max_buffer_size);
+}
 
-  if (!song->buffers) {
-    song->data = 0;
-    song->req  = 0;
+uint16_t a_song_create_pak(a_ctx* ctx, pak_t* pak, uint32_t index,
+                           const char* name, uint16_t packets_per_buffer,
+                           uint8_t buffers, uint32_t max_buffer_size) {
+  if (!pak || index >= pak_count(pak) || !packets_per_buffer || !buffers ||
+      !max_buffer_size) {
+    ASTERA_FUNC_DBG("Invalid parameters passed\n");
+    return 0;
+  }
 
-    free(song->vorbis);
+  uint32_t offset = pak_offset(pak, index);
+  uint32_t length = pak_size(pak, index);
 
-    ASTERA_FUNC_DBG("unable to allocate %i bytes for buffer IDs",
-                    (buffers * sizeof(int32_t)));
+  if (pak->is_mem) {
+    return a_song_create(ctx, pak->data.ptr + offset, length, name,
+                         packets_per_buffer, buffers, max_buffer_size);
+  }
 
+  s_map map = s_map_open(pak->data.filepath);
+  if (!map) {
     return 0;
   }
 
-  alGenBuffers(buffers, song->buffers);
-  alGenSources(1, &song->source);
+  return _a_song_create_map(ctx, map, offset, length, name,
+                            packets_per_buffer, buffers, max_buffer_size);
+}
 
-  for (uint8_t i = 0; i < buffers; ++i) {
-    uint32_t buffer = song->buffers[i], pcm_total_length = 0;
+uint16_t a_song_create_wav(a_ctx* ctx, asset_t* asset, const char* name,
+                           uint8_t buffers, uint32_t max_buffer_size) {
+  if (!asset || !asset->data || !asset->data_length || !buffers ||
+      !max_buffer_size) {
+    ASTERA_FUNC_DBG("Invalid parameters passed\n");
+    return 0;
+  }
 
-    // clear out the pcm for each buffer
-    memset(ctx->pcm, 0, sizeof(uint16_t) * ctx->pcm_length);
+  a_wav wav = {0};
+  wav.data  = asset->data;
+  wav.size  = asset->data_length;
 
-    for (uint16_t j = 0; j < packets_per_buffer; ++j) {
-      uint32_t pcm_remaining = ctx->pcm_length - pcm_total_length;
+  _a_song_lock(ctx);
+  uint16_t song_id =
+      _a_song_create_wav(ctx, &wav, name, buffers, max_buffer_size);
+  _a_song_unlock(ctx);
 
-      if ((pcm_remaining / song->info.channels) < song->info.max_frame_size) {
-        break;
-      }
+  return song_id;
+}
 
-      uint32_t num_samples = stb_vorbis_get_samples_short_interleaved(
-          song->vorbis, song->channels, ctx->pcm + pcm_total_length,
-          pcm_remaining);
+uint16_t a_song_create_wav_pak(a_ctx* ctx, pak_t* pak, uint32_t index,
+                               const char* name, uint8_t buffers,
+                               uint32_t max_buffer_size) {
+  if (!pak || index >= pak_count(pak) || !buffers || !max_buffer_size) {
+    ASTERA_FUNC_DBG("Invalid parameters passed\n");
+    return 0;
+  }
 
-      song->buffer_sizes[i] = num_samples;
+  a_wav wav = {0};
+  wav.base  = pak_offset(pak, index);
+  wav.size  = pak_size(pak, index);
 
-      if (num_samples > 0) {
-        int32_t sample_count = song->channels * num_samples;
-        pcm_total_length += sample_count;
-      }
-    }
+  if (pak->is_mem) {
+    wav.data = pak->data.ptr;
+  } else {
+    wav.file = fopen(pak->data.filepath, "rb");
 
-    alBufferData(buffer, song->format, ctx->pcm,
-                 pcm_total_length * sizeof(uint16_t), song->info.sample_rate);
-    alSourceQueueBuffers(song->source, 1, &buffer);
+    if (!wav.file) {
+      ASTERA_FUNC_DBG("unable to open pak file %s\n", pak->data.filepath);
+      return 0;
+    }
   }
 
-  if (new_high)
-    ++ctx->song_high;
-
-  ++ctx->song_count;
+  _a_song_lock(ctx);
+  uint16_t song_id =
+      _a_song_create_wav(ctx, &wav, name, buffers, max_buffer_size);
+  _a_song_unlock(ctx);
 
-  return song->id;
+  return song_id;
 }
 
 uint8_t a_song_destroy(a_ctx* ctx, uint16_t id) {
@@ -1141,17 +4695,30 @@ uint8_t a_song_destroy(a_ctx* ctx, uint16_t id) {
 
   a_song* song = &ctx->songs[id - 1];
 
+  _a_song_lock(ctx);
+
   alDeleteBuffers(song->buffer_count, song->buffers);
   alDeleteSources(1, &song->source);
 
-  stb_vorbis_close(song->vorbis);
+  _a_song_close(song);
 
-  for (uint16_t i = 0; i < ctx->layer_capacity; ++i) {
-    _a_layer_remove(&ctx->layers[i], id, 0);
-  }
+  _a_layer_remove(ctx, id, 0);
 
   free(song->buffers);
-  free(song->vorbis);
+  free(song->buffer_sizes);
+  free(song->ring);
+  free(song->pcm);
+  free(song->pcm16);
+
+  song->buffers      = 0;
+  song->buffer_sizes = 0;
+  song->ring         = 0;
+  song->pcm          = 0;
+  song->pcm16        = 0;
+  song->req          = 0;
+  song->playing      = 0;
+
+  _a_song_unlock(ctx);
 
   return 1;
 }
@@ -1190,36 +4757,30 @@ uint8_t a_song_play(a_ctx* ctx, uint16_t layer_id, uint16_t song_id,
 
   a_song* song = &ctx->songs[song_id - 1];
 
-#if !defined(ASTERA_AL_NO_FX)
-  // Apply fx
-  if (req->fx_count > 0) {
-    for (uint16_t i = 0; i < req->fx_count; ++i) {
-      // Make sure it's valid within the range of effects
-      if (req->fx[i] <= ctx->fx_capacity && req->fx[i] > 0) {
-        alSource3i(song->source, AL_AUXILIARY_SEND_FILTER,
-                   (ALint)ctx->fx_slots[req->fx[i] - 1].slot_id, i, 0);
-      } else {
-        ASTERA_FUNC_DBG("Invalid fx [%i] passed.\n", req->fx[i]);
-      }
-    }
+  // Played again while re-simulating after a restore, so keep it going
+  if (song->orphan && song->req == req) {
+    song->orphan = 0;
+    return 1;
   }
 
-  // Apply filters
-  if (req->filter_count > 0) {
-    for (uint16_t i = 0; i < req->filter_count; ++i) {
-      // Make sure it's valid within the range of filters
-      if (req->filters[i] <= ctx->filter_capacity && req->filters[i] > 0) {
-        alSourcei(song->source, AL_DIRECT_FILTER,
-                  ctx->filter_slots[req->filters[i] - 1].al_id);
-      } else {
-        ASTERA_FUNC_DBG("Invalid filter [%i] passed.\n", req->filters[i]);
-      }
-    }
-  }
-#endif
+  _a_source_fx(ctx, song->source, req, 0);
+
+  _a_song_lock(ctx);
+
+  _a_song_dsp(ctx, song, req);
 
-  song->delta = 0;
-  song->req   = req;
+  song->prefetched = 0;
+  _a_song_prefetch(song);
+
+  song->delta      = 0;
+  song->req        = req;
+  song->playing    = 1;
+  song->paused     = 0;
+  song->orphan     = 0;
+  song->sent.valid = 0;
+  song->fade       = 1.f;
+  song->fading     = 0;
+  song->fade_stop  = 0;
 
   alSourcef(song->source, AL_GAIN, req->gain);
   alSource3f(song->source, AL_POSITION, req->position[0], req->position[1],
@@ -1229,22 +4790,79 @@ uint8_t a_song_play(a_ctx* ctx, uint16_t layer_id, uint16_t song_id,
 
   alSourcePlay(song->source);
 
-  if (layer_id != 0) {
-    _a_layer_add(_a_get_layer(ctx, layer_id), song_id, 0);
+  _a_song_unlock(ctx);
+
+  a_layer* layer = _a_get_layer(ctx, layer_id);
+  if (layer) {
+    _a_layer_add(ctx, layer, song_id, 0);
+  }
+
+  return 1;
+}
+
+uint8_t a_song_stop(a_ctx* ctx, uint16_t song_id) {
+  if (ctx->song_high < song_id - 1) {
+    ASTERA_FUNC_DBG("no song in slot %i\n", song_id);
+    return 0;
   }
 
+  a_song* song = &ctx->songs[song_id - 1];
+
+  _a_song_lock(ctx);
+  song->playing      = 0;
+  song->paused       = 0;
+  song->starting     = 0;
+  song->fading       = 0;
+  song->fade_stop    = 0;
+  song->fade_partner = 0;
+  s_atomic_store(&song->priming, 0);
+  alSourceStop(song->source);
+  _a_song_unlock(ctx);
+
   return 1;
 }
 
-uint8_t a_song_stop(a_ctx* ctx, uint16_t song_id) {
-  if (ctx->song_high < song_id - 1) {
-    ASTERA_FUNC_DBG("no song in slot %i\n", song_id);
-    return 0;
-  }
+uint8_t a_song_crossfade(a_ctx* ctx, uint16_t from_id, uint16_t to_id,
+                         uint16_t layer_id, a_req* req, time_s duration) {
+  if (!to_id || ctx->song_high < to_id || !ctx->songs[to_id - 1].buffers) {
+    ASTERA_FUNC_DBG("invalid song ID %i\n", to_id);
+    return 0;
+  }
+
+  if (from_id == to_id || ctx->song_high < from_id) {
+    ASTERA_FUNC_DBG("invalid song ID %i to fade from\n", from_id);
+    return 0;
+  }
+
+  a_song* song = &ctx->songs[to_id - 1];
+
+  _a_source_fx(ctx, song->source, req, 0);
+
+  _a_song_lock(ctx);
+
+  _a_song_dsp(ctx, song, req);
+
+  _a_song_rewind(song);
+
+  song->req          = req;
+  song->playing      = 0;
+  song->paused       = 0;
+  song->orphan       = 0;
+  song->sent.valid   = 0;
+  song->fade         = 0.f;
+  song->fade_length  = (duration > 0) ? duration : 0;
+  song->fading       = 0;
+  song->fade_stop    = 0;
+  song->fade_partner = from_id;
+  song->starting     = 1;
+  s_atomic_store(&song->priming, song->buffer_count);
 
-  a_song* song = &ctx->songs[song_id - 1];
+  _a_song_unlock(ctx);
 
-  alSourceStop(song->source);
+  a_layer* layer = _a_get_layer(ctx, layer_id);
+  if (layer) {
+    _a_layer_add(ctx, layer, to_id, 0);
+  }
 
   return 1;
 }
@@ -1257,7 +4875,11 @@ uint8_t a_song_pause(a_ctx* ctx, uint16_t song_id) {
 
   a_song* song = &ctx->songs[song_id - 1];
 
+  _a_song_lock(ctx);
+  song->playing = 0;
+  song->paused  = 1;
   alSourcePause(song->source);
+  _a_song_unlock(ctx);
 
   return 1;
 }
@@ -1270,7 +4892,21 @@ uint8_t a_song_resume(a_ctx* ctx, uint16_t song_id) {
 
   a_song* song = &ctx->songs[song_id - 1];
 
+  _a_song_lock(ctx);
+  song->playing = 1;
+  song->paused  = 0;
   alSourcePlay(song->source);
+  _a_song_unlock(ctx);
+
+  // Sfx scheduled on it waited out the pause, so they go from where it is now
+  uint64_t now = a_ctx_get_sample(ctx);
+  for (uint16_t i = 0; i < ctx->sfx_capacity; ++i) {
+    a_sfx* sfx = &ctx->sfx[i];
+
+    if (sfx->scheduled && sfx->start_song == song_id) {
+      _a_sfx_follow(ctx, sfx, now);
+    }
+  }
 
   return 1;
 }
@@ -1323,7 +4959,10 @@ uint8_t a_song_set_time(a_ctx* ctx, uint16_t song_id, time_s from_start) {
     return 0;
   }
 
-  stb_vorbis_seek_frame(song->vorbis, approx_sample);
+  _a_song_lock(ctx);
+  _a_song_seek(song, approx_sample);
+  _a_song_ring_clear(song);
+  _a_song_unlock(ctx);
 
   return 1;
 }
@@ -1336,7 +4975,11 @@ uint8_t a_song_reset(a_ctx* ctx, uint16_t song_id) {
 
   a_song* song = &ctx->songs[song_id - 1];
 
-  return _a_song_reset(ctx, song);
+  _a_song_lock(ctx);
+  uint8_t result = _a_song_reset(song);
+  _a_song_unlock(ctx);
+
+  return result;
 }
 
 uint32_t a_song_get_state(a_ctx* ctx, uint16_t song_id) {
@@ -1371,14 +5014,6 @@ uint16_t a_song_get_id(a_ctx* ctx, const char* name) {
   return 0;
 }
 
-static int16_t _a_load_int16(unsigned char* data, int offset) {
-  return *((int16_t*)&data[offset]);
-}
-
-static int32_t _a_load_int32(unsigned char* data, int offset) {
-  return *((int32_t*)&data[offset]);
-}
-
 uint16_t a_buf_create(a_ctx* ctx, unsigned char* data, uint32_t data_length,
                       const char* name, uint8_t is_ogg) {
   if (!data || !data_length) {
@@ -1386,68 +5021,47 @@ uint16_t a_buf_create(a_ctx* ctx, unsigned char* data, uint32_t data_length,
     return 0;
   }
 
-  if (ctx->buffer_count == ctx->buffer_capacity) {
-    ASTERA_FUNC_DBG("no free buffer slots.\n");
-    return 0;
-  }
-
-  a_buf* buffer = 0;
-
-  // Find open buffer
-  for (uint16_t i = 0; i < ctx->buffer_high; ++i) {
-    if (ctx->buffers[i].buf == 0) {
-      buffer = &ctx->buffers[i];
-      break;
-    }
-  }
+  a_buf* buffer = _a_buf_slot(ctx);
 
-  int8_t new_high = 0;
-  if (!buffer && ctx->buffer_high < ctx->buffer_capacity - 1) {
-    buffer   = &ctx->buffers[ctx->buffer_high];
-    new_high = 1;
-  } else {
+  if (!buffer) {
     ASTERA_FUNC_DBG("no free buffer slots.\n");
     return 0;
   }
 
-  alGenBuffers(1, &buffer->buf);
-
   if (is_ogg) {
-    int32_t error;
-
-    stb_vorbis* vorbis = stb_vorbis_open_memory(data, data_length, &error, 0);
-
-    if (!vorbis) {
-      ASTERA_FUNC_DBG("unable to open vorbis header, vorbis error %i\n", error);
+    if (!_a_buf_ogg_info(ctx, buffer, data, data_length)) {
       return 0;
     }
 
-    uint16_t* pcm;
-    int32_t   format, sample_rate, channels;
-
-    int32_t byte_length = stb_vorbis_decode_memory(data, data_length, &channels,
-                                                   &sample_rate, (short**)&pcm);
-
-    format = (channels > 1) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
-
-    buffer->length      = vorbis->total_samples;
-    buffer->sample_rate = sample_rate;
-    buffer->channels    = channels;
+    // Callers are free to drop their data, so keep the (small) compressed
+    // copy around to decode from when it's first played
+    buffer->ogg = (unsigned char*)malloc(data_length);
+    if (!buffer->ogg) {
+      ASTERA_FUNC_DBG("unable to allocate %i bytes for OGG data.\n",
+                      data_length);
+      return 0;
+    }
 
-    alBufferData(buffer->buf, format, pcm, byte_length, sample_rate);
+    memcpy(buffer->ogg, data, data_length);
+    buffer->ogg_length = data_length;
+    buffer->checksum   = _a_fnv1a(data, data_length);
 
-    free(vorbis);
+    alGenBuffers(1, &buffer->buf);
+    s_atomic_store(&buffer->state, A_BUF_EMPTY);
   } else {
-    int16_t channels    = _a_load_int16(data, 22);
-    int32_t sample_rate = _a_load_int32(data, 24);
-    // int32_t byte_rate   = _a_load_int32(data, 28);
-    int32_t bps = _a_load_int16(data, 34);
+    a_wav    wav         = {0};
+    uint16_t channels    = 0;
+    uint32_t sample_rate = 0;
+
+    wav.data = data;
+    wav.size = data_length;
 
-    if (strncmp((const char*)&data[36], "data", 4) != 0) {
+    if (!_a_wav_parse(&wav, &channels, &sample_rate)) {
       return 0;
     }
 
-    int32_t byte_length = _a_load_int32(data, 40);
+    int32_t bps         = wav.bits;
+    int32_t byte_length = wav.pcm_length;
 
     int32_t format = -1;
     if (channels == 2) {
@@ -1463,20 +5077,130 @@ uint16_t a_buf_create(a_ctx* ctx, unsigned char* data, uint32_t data_length,
 
     buffer->channels    = channels;
     buffer->sample_rate = sample_rate;
-    buffer->length      = (uint32_t)byte_length / bps;
+    buffer->length      = (uint32_t)byte_length / (bps / 8) / channels;
+
+    int16_t* converted = 0;
+
+    if (ctx->buf_rate && sample_rate != ctx->buf_rate) {
+      converted = _a_resample(&data[wav.pcm_offset], bps, buffer->length,
+                              channels, sample_rate, ctx->buf_rate,
+                              &buffer->length);
+
+      if (!converted) {
+        ASTERA_FUNC_DBG("unable to resample %iHz to %iHz.\n", sample_rate,
+                        ctx->buf_rate);
+        return 0;
+      }
+
+      byte_length         = buffer->length * channels * sizeof(int16_t);
+      buffer->sample_rate = ctx->buf_rate;
+
+      format = (channels == 2) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+    }
 
-    alBufferData(buffer->buf, format, &data[44], byte_length, sample_rate);
+    alGenBuffers(1, &buffer->buf);
+    alBufferData(buffer->buf, format,
+                 (converted) ? (void*)converted : &data[wav.pcm_offset],
+                 byte_length, buffer->sample_rate);
+    s_atomic_store(&buffer->state, A_BUF_READY);
+
+    free(converted);
   }
 
   ctx->buffer_names[buffer->id - 1] = name;
 
-  if (new_high)
+  if (buffer->id > ctx->buffer_high)
     ++ctx->buffer_high;
 
   ++ctx->buffer_count;
   return buffer->id;
 }
 
+uint16_t a_buf_preload(a_ctx* ctx, pak_t* pak, const char** names,
+                       uint16_t count, uint16_t* ids) {
+  if (!pak || !names || !ids) {
+    ASTERA_FUNC_DBG("no pak, names or IDs passed.\n");
+    return 0;
+  }
+
+  uint8_t  queue   = _a_decode_start(ctx);
+  uint16_t created = 0;
+
+  for (uint16_t i = 0; i < count; ++i) {
+    int32_t index = pak_find(pak, names[i]);
+    a_buf*  buf   = (index >= 0) ? _a_buf_slot(ctx) : 0;
+
+    ids[i] = 0;
+
+    if (!buf) {
+      ASTERA_FUNC_DBG("unable to preload %s\n", names[i]);
+      continue;
+    }
+
+    buf->pak       = pak;
+    buf->pak_index = (uint32_t)index;
+    buf->channels  = 1;
+    buf->length    = 0;
+
+    alGenBuffers(1, &buf->buf);
+    ctx->buffer_names[buf->id - 1] = names[i];
+
+    if (buf->id > ctx->buffer_high)
+      ++ctx->buffer_high;
+
+    ++ctx->buffer_count;
+    ids[i] = buf->id;
+    ++created;
+
+    // Without the decode thread they're loaded in place
+    if (queue) {
+      s_atomic_store(&buf->state, A_BUF_LOADING);
+      continue;
+    }
+
+    buf->pcm = _a_buf_load(ctx, buf);
+
+    if (buf->pcm) {
+      _a_buf_upload(ctx, buf);
+    } else {
+      s_atomic_store(&buf->state, A_BUF_FAILED);
+    }
+  }
+
+  return created;
+}
+
+uint16_t a_buf_preload_poll(a_ctx* ctx, const uint16_t* ids, uint16_t count,
+                            uint16_t* failed) {
+  uint16_t done = 0, bad = 0;
+
+  for (uint16_t i = 0; i < count; ++i) {
+    if (!ids[i] || ids[i] > ctx->buffer_capacity) {
+      ++done;
+      ++bad;
+      continue;
+    }
+
+    uint32_t state = s_atomic_load(&ctx->buffers[ids[i] - 1].state);
+
+    if (state == A_BUF_FAILED) {
+      ++bad;
+    }
+
+    // Evicted OGG buffers are back to empty, but they did load
+    if (state == A_BUF_READY || state == A_BUF_FAILED ||
+        state == A_BUF_EMPTY) {
+      ++done;
+    }
+  }
+
+  if (failed) {
+    *failed = bad;
+  }
+
+  return done;
+}
+
 uint8_t a_buf_destroy(a_ctx* ctx, uint16_t buf_id) {
   if (ctx->buffer_high < buf_id - 1) {
     ASTERA_FUNC_DBG("no buffer in slot %i\n", buf_id);
@@ -1484,9 +5208,33 @@ uint8_t a_buf_destroy(a_ctx* ctx, uint16_t buf_id) {
   }
 
   a_buf* buffer = &ctx->buffers[buf_id - 1];
+
+  if (buffer->users) {
+    ASTERA_FUNC_DBG("buffer %i is still being played.\n", buf_id);
+    return 0;
+  }
+
+  _a_buf_settle(buffer);
+
   alDeleteBuffers(1, (const ALuint*)&buffer->buf);
   buffer->buf = 0;
 
+  free(buffer->ogg);
+  free(buffer->pcm);
+
+  ctx->pcm_bytes -= buffer->bytes;
+
+  buffer->ogg        = 0;
+  buffer->ogg_length = 0;
+  buffer->pcm        = 0;
+  buffer->bytes      = 0;
+  buffer->last_use   = 0;
+  buffer->pak        = 0;
+  s_atomic_store(&buffer->state, A_BUF_EMPTY);
+
+  ctx->buffer_names[buf_id - 1] = 0;
+  --ctx->buffer_count;
+
   return 1;
 }
 
@@ -1582,7 +5330,11 @@ a_req a_req_create(vec3 position, float gain, float range, uint8_t loop,
 }
 
 uint16_t a_fx_create(a_ctx* ctx, a_fx_type type, void* data) {
-#if !defined(ASTERA_AL_NO_FX)
+  if (!ctx->use_fx && !ctx->soft_fx) {
+    ASTERA_FUNC_DBG("effects aren't enabled on this context.\n");
+    return 0;
+  }
+
   if (!(type == FX_REVERB || type == FX_EQ)) {
     ASTERA_FUNC_DBG("invalid type of effect passed.\n");
     return 0;
@@ -1596,7 +5348,7 @@ uint16_t a_fx_create(a_ctx* ctx, a_fx_type type, void* data) {
   a_fx* slot = 0;
 
   for (uint16_t i = 0; i < ctx->fx_capacity; ++i) {
-    if (ctx->fx_slots[i].effect_id == 0) {
+    if (ctx->fx_slots[i].type == FX_NONE) {
       slot = &ctx->fx_slots[i];
       break;
     }
@@ -1608,6 +5360,15 @@ uint16_t a_fx_create(a_ctx* ctx, a_fx_type type, void* data) {
   }
 
   ++ctx->fx_count;
+
+  // Software effects are read out of the slot by songs' chains as they run
+  if (!ctx->use_fx) {
+    slot->data = data;
+    slot->type = type;
+    return slot->id;
+  }
+
+#if !defined(ASTERA_AL_NO_FX)
   alGenEffects(1, &slot->effect_id);
   alGenAuxiliaryEffectSlots(1, &slot->slot_id);
   alAuxiliaryEffectSloti(slot->slot_id, AL_EFFECTSLOT_AUXILIARY_SEND_AUTO,
@@ -1663,17 +5424,14 @@ uint16_t a_fx_create(a_ctx* ctx, a_fx_type type, void* data) {
 
   alAuxiliaryEffectSloti(slot->slot_id, AL_EFFECTSLOT_EFFECT, slot->effect_id);
 
+#endif
+
   // NOTE: slot->id is the index + 1 of the slot in the context's array of
   // slots
   return slot->id;
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return 0;
-#endif
 }
 
 uint8_t a_fx_destroy(a_ctx* ctx, uint16_t fx_id) {
-#if !defined(ASTERA_AL_NO_FX)
   if (fx_id <= 0 || fx_id > ctx->fx_capacity) {
     ASTERA_FUNC_DBG("no fx in that slot.\n");
     return 0;
@@ -1681,40 +5439,47 @@ uint8_t a_fx_destroy(a_ctx* ctx, uint16_t fx_id) {
 
   a_fx* slot = &ctx->fx_slots[fx_id - 1];
 
-  if (!slot) {
-    ASTERA_FUNC_DBG("invalid slot pointer.\n");
-    return 0;
-  }
-
-  if (slot->id == 0) {
+  if (slot->type == FX_NONE) {
     ASTERA_FUNC_DBG("no fx in that slot.\n");
     return 0;
   }
 
+#if !defined(ASTERA_AL_NO_FX)
   if (slot->effect_id != 0)
     alDeleteEffects(1, &slot->effect_id);
 
   if (slot->slot_id != 0)
     alDeleteAuxiliaryEffectSlots(1, &slot->slot_id);
+#endif
+
+  // Songs' software chains drop the slot once it's cleared
+  _a_song_lock(ctx);
 
   --ctx->fx_count;
-  slot->id = 0;
+  slot->effect_id = 0;
+  slot->slot_id   = 0;
+  slot->type      = FX_NONE;
+  slot->data      = 0;
+
+  _a_song_unlock(ctx);
 
   return 1;
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return 0;
-#endif
 }
 
 uint8_t a_fx_update(a_ctx* ctx, uint16_t fx_id) {
-#if !defined(ASTERA_AL_NO_FX)
   if (fx_id <= 0 || fx_id > ctx->fx_capacity) {
     ASTERA_FUNC_DBG("no fx in slot: %i\n", fx_id);
     return 0;
   }
 
   a_fx* slot = &ctx->fx_slots[fx_id - 1];
+
+  // Software chains pick up changed values on their own
+  if (!ctx->use_fx) {
+    return slot->type != FX_NONE;
+  }
+
+#if !defined(ASTERA_AL_NO_FX)
   switch (slot->type) {
     case FX_NONE:
       return 0;
@@ -1752,44 +5517,30 @@ uint8_t a_fx_update(a_ctx* ctx, uint16_t fx_id) {
       alEffecti(slot->effect_id, AL_REVERB_DECAY_HFLIMIT, rv->decay_hflimit);
     } break;
   }
+#endif
 
   return 1;
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return 0;
-#endif
 }
 
 a_fx_type a_fx_get_type(a_ctx* ctx, uint16_t fx_id) {
-#if !defined(ASTERA_AL_NO_FX)
   if (fx_id <= 0 || fx_id > ctx->fx_capacity) {
     ASTERA_FUNC_DBG("no fx in slot %i\n", fx_id);
     return 0;
   }
 
   return ctx->fx_slots[fx_id - 1].type;
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return 0;
-#endif
 }
 
 a_fx* a_fx_get_slot(a_ctx* ctx, uint16_t fx_id) {
-#if !defined(ASTERA_AL_NO_FX)
   if (fx_id <= 0 || fx_id > ctx->fx_capacity) {
     ASTERA_FUNC_DBG("no fx in slot %i\n", fx_id);
     return 0;
   }
 
   return &ctx->fx_slots[fx_id - 1];
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return 0;
-#endif
 }
 
 a_fx_reverb a_fx_reverb_default(void) {
-#if !defined(ASTERA_AL_NO_FX)
   return (a_fx_reverb){
       .density               = AL_REVERB_DEFAULT_DENSITY,
       .diffusion             = AL_REVERB_DEFAULT_DIFFUSION,
@@ -1804,10 +5555,6 @@ a_fx_reverb a_fx_reverb_default(void) {
       .air_absorption_gainhf = AL_REVERB_DEFAULT_AIR_ABSORPTION_GAINHF,
       .room_rolloff_factor   = AL_REVERB_DEFAULT_ROOM_ROLLOFF_FACTOR,
       .decay_hflimit         = AL_REVERB_DEFAULT_DECAY_HFLIMIT};
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return (a_fx_reverb){0};
-#endif
 }
 
 a_fx_reverb a_fx_reverb_create(float density, float diffusion, float gain,
@@ -1817,7 +5564,6 @@ a_fx_reverb a_fx_reverb_create(float density, float diffusion, float gain,
                                float  air_absorption_gainhf,
                                float  room_rolloff_factor,
                                int8_t decay_hflimit) {
-#if !defined(ASTERA_AL_NO_FX)
   a_fx_reverb rev;
   rev = (a_fx_reverb){
       .density   = _a_clamp(density, 0.f, 1.f, AL_REVERB_DEFAULT_DENSITY),
@@ -1843,17 +5589,12 @@ a_fx_reverb a_fx_reverb_create(float density, float diffusion, float gain,
       .decay_hflimit = (decay_hflimit) ? 1 : AL_REVERB_DEFAULT_DECAY_HFLIMIT};
 
   return rev;
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return (a_fx_reverb){0};
-#endif
 }
 
 a_fx_eq a_fx_eq_create(float low_gain, float low_cutoff, float mid1_gain,
                        float mid1_center, float mid1_width, float mid2_gain,
                        float mid2_center, float mid2_width, float high_gain,
                        float high_cutoff) {
-#if !defined(ASTERA_AL_NO_FX)
   return (a_fx_eq){.low_gain    = _a_clamp(low_gain, 0.126f, 7.943f, 1.f),
                    .low_cutoff  = _a_clamp(low_cutoff, 50.f, 800.f, 200.f),
                    .mid1_gain   = _a_clamp(mid1_gain, 0.126f, 7.943f, 1.f),
@@ -1865,15 +5606,15 @@ a_fx_eq a_fx_eq_create(float low_gain, float low_cutoff, float mid1_gain,
                    .high_gain   = _a_clamp(high_gain, 0.126f, 7.943f, 1.f),
                    .high_cutoff =
                        _a_clamp(high_cutoff, 4000.f, 16000.f, 6000.f)};
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return (a_fx_eq){0};
-#endif
 }
 
 uint16_t a_filter_create(a_ctx* ctx, a_filter_type type, float gain, float hf,
                          float lf) {
-#if !defined(ASTERA_AL_NO_FX)
+  if (!ctx->use_fx && !ctx->soft_fx) {
+    ASTERA_FUNC_DBG("filters aren't enabled on this context.\n");
+    return 0;
+  }
+
   if (ctx->filter_count == ctx->filter_capacity) {
     ASTERA_FUNC_DBG("no free slots.\n");
     return 0;
@@ -1882,7 +5623,7 @@ uint16_t a_filter_create(a_ctx* ctx, a_filter_type type, float gain, float hf,
   a_filter* slot = 0;
 
   for (uint16_t i = 0; i < ctx->filter_capacity; ++i) {
-    if (!ctx->filter_slots[i].al_id) {
+    if (!ctx->filter_slots[i].type) {
       slot = &ctx->filter_slots[i];
       break;
     }
@@ -1892,55 +5633,53 @@ uint16_t a_filter_create(a_ctx* ctx, a_filter_type type, float gain, float hf,
     return 0;
   }
 
-  ++ctx->filter_count;
-
-  if (!slot->al_id) {
-    alGenFilters(1, &slot->al_id);
-  }
-
   slot->gain = _a_clamp(gain, 0.f, 1.f, 1.f);
-  slot->type = type;
 
   switch (type) {
     case FILTER_LOW:
-      alFilteri(slot->al_id, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
-
       slot->data.low.gainhf = _a_clamp(hf, 0.f, 1.f, 1.f);
-
-      alFilterf(slot->al_id, AL_LOWPASS_GAIN, slot->gain);
-      alFilterf(slot->al_id, AL_LOWPASS_GAINHF, slot->data.low.gainhf);
-
       break;
     case FILTER_HIGH:
-      alFilteri(slot->al_id, AL_FILTER_TYPE, AL_FILTER_HIGHPASS);
-
       slot->data.high.gainlf = _a_clamp(lf, 0.f, 1.f, 1.f);
-
-      alFilterf(slot->al_id, AL_HIGHPASS_GAIN, slot->gain);
-      alFilterf(slot->al_id, AL_HIGHPASS_GAINLF, slot->data.high.gainlf);
-
       break;
     case FILTER_BAND:
-      alFilteri(slot->al_id, AL_FILTER_TYPE, AL_FILTER_BANDPASS);
-
       slot->data.band.gainlf = _a_clamp(lf, 0.f, 1.f, 1.f);
       slot->data.band.gainhf = _a_clamp(hf, 0.f, 1.f, 1.f);
-
-      alFilterf(slot->al_id, AL_BANDPASS_GAIN, slot->gain);
-      alFilterf(slot->al_id, AL_BANDPASS_GAINLF, slot->data.band.gainlf);
-      alFilterf(slot->al_id, AL_BANDPASS_GAINHF, slot->data.band.gainhf);
       break;
+    default:
+      ASTERA_FUNC_DBG("invalid type of filter passed.\n");
+      return 0;
   }
 
-  return slot->id;
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return 0;
+  slot->type = type;
+  ++ctx->filter_count;
+
+#if !defined(ASTERA_AL_NO_FX)
+  if (ctx->use_fx) {
+    if (!slot->al_id) {
+      alGenFilters(1, &slot->al_id);
+    }
+
+    switch (type) {
+      case FILTER_LOW:
+        alFilteri(slot->al_id, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
+        break;
+      case FILTER_HIGH:
+        alFilteri(slot->al_id, AL_FILTER_TYPE, AL_FILTER_HIGHPASS);
+        break;
+      case FILTER_BAND:
+        alFilteri(slot->al_id, AL_FILTER_TYPE, AL_FILTER_BANDPASS);
+        break;
+    }
+
+    a_filter_update(ctx, slot->id);
+  }
 #endif
+
+  return slot->id;
 }
 
 uint8_t a_filter_update(a_ctx* ctx, uint16_t filter_id) {
-#if !defined(ASTERA_AL_NO_FX)
   if (filter_id > ctx->filter_capacity || filter_id <= 0) {
     ASTERA_FUNC_DBG("no filter in slot %i\n", filter_id);
     return 0;
@@ -1948,6 +5687,12 @@ uint8_t a_filter_update(a_ctx* ctx, uint16_t filter_id) {
 
   a_filter* slot = &ctx->filter_slots[filter_id - 1];
 
+  // Software chains pick up changed values on their own
+  if (!ctx->use_fx) {
+    return slot->type != 0;
+  }
+
+#if !defined(ASTERA_AL_NO_FX)
   switch (slot->type) {
     case FILTER_LOW:
       alFilterf(slot->al_id, AL_LOWPASS_GAIN, slot->gain);
@@ -1963,44 +5708,49 @@ uint8_t a_filter_update(a_ctx* ctx, uint16_t filter_id) {
       alFilterf(slot->al_id, AL_BANDPASS_GAINHF, slot->data.band.gainhf);
       break;
   }
+#endif
 
   return 1;
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return 0;
-#endif
 }
 
 uint8_t a_filter_destroy(a_ctx* ctx, uint16_t filter_id) {
-#if !defined(ASTERA_AL_NO_FX)
   if (filter_id > ctx->filter_capacity || filter_id <= 0) {
     ASTERA_FUNC_DBG("no filter in slot %i\n", filter_id);
     return 0;
   }
 
-  alDeleteFilters(1, &ctx->filter_slots[filter_id - 1].al_id);
-  ctx->filter_slots[filter_id - 1].al_id = 0;
+  a_filter* slot = &ctx->filter_slots[filter_id - 1];
+
+  if (!slot->type) {
+    ASTERA_FUNC_DBG("no filter in slot %i\n", filter_id);
+    return 0;
+  }
+
+#if !defined(ASTERA_AL_NO_FX)
+  if (slot->al_id) {
+    alDeleteFilters(1, &slot->al_id);
+  }
+#endif
+
+  // Songs' software chains drop the slot once it's cleared
+  _a_song_lock(ctx);
+
+  slot->al_id = 0;
+  slot->type  = 0;
   --ctx->filter_count;
 
+  _a_song_unlock(ctx);
+
   return 1;
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return 0;
-#endif
 }
 
 a_filter* a_filter_get_slot(a_ctx* ctx, uint16_t filter_id) {
-#if !defined(ASTERA_AL_NO_FX)
   if (filter_id > ctx->filter_capacity || filter_id <= 0) {
     ASTERA_FUNC_DBG("no filter in slot %i\n", filter_id);
     return 0;
   }
 
   return &ctx->filter_slots[filter_id - 1];
-#else
-  ASTERA_FUNC_DBG("ASTERA_AL_NO_FX is defined\n");
-  return 0;
-#endif
 }
 
 uint16_t a_layer_create(a_ctx* ctx, const char* name, uint32_t max_sfx,
@@ -2024,11 +5774,11 @@ uint16_t a_layer_create(a_ctx* ctx, const char* name, uint32_t max_sfx,
 
   layer->name = name;
 
-  layer->sfx          = (uint32_t*)calloc(max_sfx, sizeof(uint32_t));
+  layer->sfx_head     = 0;
   layer->sfx_capacity = max_sfx;
   layer->sfx_count    = 0;
 
-  layer->songs         = (uint32_t*)calloc(max_songs, sizeof(uint32_t));
+  layer->song_head     = 0;
   layer->song_capacity = max_songs;
   layer->song_count    = 0;
 
@@ -2037,6 +5787,63 @@ uint16_t a_layer_create(a_ctx* ctx, const char* name, uint32_t max_sfx,
   return layer->id;
 }
 
+uint16_t a_group_create(a_ctx* ctx, const char* name, const uint16_t* buf_ids,
+                        uint16_t count) {
+  if (!name || !buf_ids || !count || count > ASTERA_AUDIO_GROUP_SIZE) {
+    ASTERA_FUNC_DBG("invalid group of %i buffers passed.\n", count);
+    return 0;
+  }
+
+  for (uint16_t i = 0; i < count; ++i) {
+    uint16_t id = buf_ids[i];
+
+    if (!id || id > ctx->buffer_capacity || !ctx->buffers[id - 1].buf) {
+      ASTERA_FUNC_DBG("no buffer with ID %i\n", id);
+      return 0;
+    }
+  }
+
+  for (uint16_t i = 0; i < ASTERA_AUDIO_GROUPS; ++i) {
+    a_group* group = &ctx->groups[i];
+
+    if (group->name) {
+      continue;
+    }
+
+    memcpy(group->bufs, buf_ids, sizeof(uint16_t) * count);
+    group->name  = name;
+    group->count = count;
+    group->last  = count;
+
+    return i + 1;
+  }
+
+  ASTERA_FUNC_DBG("no free group slots.\n");
+  return 0;
+}
+
+uint16_t a_group_get(a_ctx* ctx, const char* name) {
+  for (uint16_t i = 0; i < ASTERA_AUDIO_GROUPS; ++i) {
+    if (ctx->groups[i].name && strcmp(name, ctx->groups[i].name) == 0) {
+      return i + 1;
+    }
+  }
+
+  return 0;
+}
+
+uint8_t a_group_destroy(a_ctx* ctx, uint16_t group_id) {
+  if (!group_id || group_id > ASTERA_AUDIO_GROUPS ||
+      !ctx->groups[group_id - 1].name) {
+    ASTERA_FUNC_DBG("no group with ID %i\n", group_id);
+    return 0;
+  }
+
+  ctx->groups[group_id - 1] = (a_group){0};
+
+  return 1;
+}
+
 uint16_t a_layer_get_id(a_ctx* ctx, const char* name) {
   for (uint16_t i = 0; i < ctx->layer_capacity; ++i) {
     if (ctx->layers[i].id != 0 && ctx->layers[i].name) {
@@ -2056,7 +5863,7 @@ uint8_t a_layer_destroy(a_ctx* ctx, uint16_t layer_id) {
     return 0;
   }
 
-  _a_layer_destroy(layer);
+  _a_layer_destroy(ctx, layer);
   --ctx->layer_count;
 
   return 1;
@@ -2067,7 +5874,7 @@ uint8_t a_layer_add_sfx(a_ctx* ctx, uint16_t layer_id, uint16_t sfx_id) {
   if (!layer)
     return 0;
 
-  return _a_layer_add(layer, sfx_id, 1);
+  return _a_layer_add(ctx, layer, sfx_id, 1);
 }
 
 uint8_t a_layer_add_song(a_ctx* ctx, uint16_t layer_id, uint16_t song_id) {
@@ -2075,23 +5882,23 @@ uint8_t a_layer_add_song(a_ctx* ctx, uint16_t layer_id, uint16_t song_id) {
   if (!layer)
     return 0;
 
-  return _a_layer_add(layer, song_id, 0);
+  return _a_layer_add(ctx, layer, song_id, 0);
 }
 
 uint8_t a_layer_remove_sfx(a_ctx* ctx, uint16_t layer_id, uint16_t sfx_id) {
   a_layer* layer = _a_get_layer(ctx, layer_id);
-  if (!layer)
+  if (!layer || ctx->sfx[sfx_id - 1].link.layer != layer_id)
     return 0;
 
-  return _a_layer_remove(layer, sfx_id, 1);
+  return _a_layer_remove(ctx, sfx_id, 1);
 }
 
 uint8_t a_layer_remove_song(a_ctx* ctx, uint16_t layer_id, uint16_t song_id) {
   a_layer* layer = _a_get_layer(ctx, layer_id);
-  if (!layer)
+  if (!layer || ctx->songs[song_id - 1].link.layer != layer_id)
     return 0;
 
-  return _a_layer_remove(layer, song_id, 0);
+  return _a_layer_remove(ctx, song_id, 0);
 }
 
 uint8_t a_layer_set_gain(a_ctx* ctx, uint16_t layer_id, float gain) {
@@ -13,9 +13,31 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+// Kept static so it doesn't clash with the copy in fontstash (ui)
+#define STB_TRUETYPE_IMPLEMENTATION
+#define STBTT_STATIC
+#include <stb_truetype.h>
+
 // For callbacks only
 static r_ctx* _r_ctx;
 
+// Multi draw indirect isn't part of the GL 3.3 loader, so it's loaded manually
+#if !defined(GL_DRAW_INDIRECT_BUFFER)
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+typedef void(GLAD_API_PTR* r_multi_draw_indirect_proc)(GLenum, GLenum,
+                                                        const void*, GLsizei,
+                                                        GLsizei);
+static r_multi_draw_indirect_proc _r_multi_draw_elements_indirect;
+
+// Layout defined by GL for glMultiDrawElementsIndirect
+typedef struct {
+  uint32_t count, instance_count, first_index;
+  int32_t  base_vertex;
+  uint32_t base_instance;
+} r_draw_cmd;
+
 static void glfw_err_cb(int error, const char* msg) {
   ASTERA_DBG("GLFW ERROR: %i %s\n", error, msg);
   printf("GLFW error: %i %s\n", error, msg);
@@ -125,61 +147,125 @@ static void r_batch_check(r_batch* batch) {
   }
 }
 
-static void r_batch_add(r_batch* batch, r_sprite* sprite) {
-  batch->flip_x[batch->count] = sprite->flip_x;
-  batch->flip_y[batch->count] = sprite->flip_y;
+// Get the subtex ID of the frame an animated sprite is currently on
+static inline uint32_t r_sprite_frame(r_sprite* sprite) {
+  r_anim_viewer* view = &sprite->render.anim;
+
+  // Empty animations have no frame to read, fall back to the sheet's first
+  if (!view->anim || !view->anim->count) {
+    return 0;
+  }
+
+  if (view->clock) {
+    return view->anim->frames[r_anim_clock_frame(view->clock, view->phase)];
+  }
+
+  return view->anim->frames[view->curr];
+}
 
-  mat4x4_dup(batch->mats[batch->count], sprite->model);
-  vec4_dup(batch->colors[batch->count], sprite->color);
+static void r_batch_set(r_batch* batch, uint32_t index, r_sprite* sprite) {
+  batch->flip_x[index] = sprite->flip_x;
+  batch->flip_y[index] = sprite->flip_y;
+
+  mat4x4_dup(batch->mats[index], sprite->model);
+  vec4_dup(batch->colors[index], sprite->color);
 
   if (sprite->animated) {
-    vec4_dup(batch->coords[batch->count],
-             batch->sheet
-                 ->subtexs[sprite->render.anim.anim
-                               ->frames[sprite->render.anim.curr]]
-                 .coords);
+    vec4_dup(batch->coords[index],
+             batch->sheet->subtexs[r_sprite_frame(sprite)].coords);
   } else {
-    vec4_dup(batch->coords[batch->count],
+    vec4_dup(batch->coords[index],
              batch->sheet->subtexs[sprite->render.tex].coords);
   }
+}
 
+static void r_batch_add(r_batch* batch, r_sprite* sprite) {
+  r_batch_set(batch, batch->count, sprite);
   ++batch->count;
 }
 
-static uint32_t r_batch_add_multi(r_batch* batch, r_sprite* sprites,
-                                  uint32_t count) {
-  for (uint32_t i = 0; i < count; ++i) {
-    if (batch->count == batch->capacity)
-      return i;
-    batch->flip_x[batch->count] = sprites[i].flip_x;
-    batch->flip_y[batch->count] = sprites[i].flip_y;
-
-    mat4x4_dup(batch->mats[batch->count], sprites[i].model);
-    vec4_dup(batch->colors[batch->count], sprites[i].color);
-
-    if (sprites[i].animated) {
-      vec4_dup(batch->coords[batch->count],
-               batch->sheet
-                   ->subtexs[sprites[i].render.anim.anim->frames
-                                 [sprites[i].render.anim.curr]]
-                   .coords);
-    } else {
-      vec4_dup(batch->coords[batch->count],
-               batch->sheet->subtexs[sprites[i].render.tex].coords);
+// Check if a sprite can be drawn without blending (in the opaque pass)
+static inline uint8_t r_sprite_opaque(r_sprite* sprite) {
+  if (sprite->color[3] < 1.f) {
+    return 0;
+  }
+
+  uint32_t tex = (sprite->animated) ? r_sprite_frame(sprite)
+                                    : sprite->render.tex;
+  return sprite->sheet->subtexs[tex].opaque;
+}
+
+static int r_sort_key_cmp(const void* a, const void* b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+// Gather `size` byte elements of an array into key order, via the scratch
+static void r_batch_permute(r_batch* batch, void* array, size_t size) {
+  unsigned char* src = (unsigned char*)array;
+  unsigned char* dst = (unsigned char*)batch->sort_scratch;
+
+  for (uint32_t i = 0; i < batch->count; ++i) {
+    memcpy(dst + i * size, src + (batch->sort_keys[i] & 0xFFFFFFFF) * size,
+           size);
+  }
+
+  memcpy(src, dst, size * batch->count);
+}
+
+// Sort a batch by depth (model z), stable so equal depths keep their order
+// front_to_back - 1 = nearest first (opaque), 0 = furthest first (translucent)
+static void r_batch_sort(r_batch* batch, uint8_t front_to_back) {
+  if (batch->count < 2) {
+    return;
+  }
+
+  if (!batch->sort_keys) {
+    batch->sort_keys    = (uint64_t*)malloc(sizeof(uint64_t) * batch->capacity);
+    batch->sort_scratch = malloc(sizeof(mat4x4) * batch->capacity);
+  }
+
+  // Keys are the depth's bits flipped to order as unsigned ints, with the
+  // index in the low bits so qsort keeps equal depths in order
+  uint8_t sorted = 1;
+  for (uint32_t i = 0; i < batch->count; ++i) {
+    uint32_t bits;
+    memcpy(&bits, &batch->mats[i][3][2], sizeof(uint32_t));
+    bits ^= (bits & 0x80000000) ? 0xFFFFFFFF : 0x80000000;
+
+    if (front_to_back) {
+      bits = ~bits;
+    }
+
+    batch->sort_keys[i] = ((uint64_t)bits << 32) | i;
+
+    if (i && batch->sort_keys[i] < batch->sort_keys[i - 1]) {
+      sorted = 0;
     }
+  }
 
-    ++batch->count;
+  // Sprites submitted in depth order need nothing moved
+  if (sorted) {
+    return;
   }
 
-  return count;
+  qsort(batch->sort_keys, batch->count, sizeof(uint64_t), r_sort_key_cmp);
+
+  r_batch_permute(batch, batch->mats, sizeof(mat4x4));
+  r_batch_permute(batch, batch->colors, sizeof(vec4));
+  r_batch_permute(batch, batch->coords, sizeof(vec4));
+  r_batch_permute(batch, batch->flip_x, sizeof(int));
+  r_batch_permute(batch, batch->flip_y, sizeof(int));
 }
 
-static r_batch* r_batch_get(r_ctx* ctx, r_sheet* sheet, r_shader shader) {
+static r_batch* r_batch_get(r_ctx* ctx, r_sheet* sheet, r_shader shader,
+                            uint8_t opaque) {
   for (uint32_t i = 0; i < ctx->batch_capacity; ++i) {
     r_batch* batch = &ctx->batches[i];
 
     if (batch->sheet && batch->shader) {
-      if (sheet->id == batch->sheet->id && shader == batch->shader) {
+      if (sheet->id == batch->sheet->id && shader == batch->shader &&
+          opaque == batch->opaque) {
         return batch;
       }
     }
@@ -192,11 +278,18 @@ static r_batch* r_batch_get(r_ctx* ctx, r_sheet* sheet, r_shader shader) {
       r_batch_check(batch);
       batch->sheet  = sheet;
       batch->shader = shader;
+      batch->opaque = opaque;
 
       return batch;
     }
   }
 
+  // Out of slots, opaque sprites still draw right with blending (only losing
+  // the front to back order), so they share the translucent batch instead
+  if (opaque) {
+    return r_batch_get(ctx, sheet, shader, 0);
+  }
+
   return 0;
 }
 
@@ -253,6 +346,239 @@ static void r_batch_draw(r_ctx* ctx, r_batch* batch) {
   r_shader_bind(0);
 }
 
+// Offsets of each array in an instance buffer (laid out the same as the batch
+// arrays so each one can be copied straight in: [mats][coords][colors][flip_x]
+// [flip_y]), index 5 being the total size of the buffer
+static void r_instance_offsets(size_t offsets[6], uint32_t capacity) {
+  offsets[0] = 0;
+  offsets[1] = offsets[0] + sizeof(mat4x4) * capacity;
+  offsets[2] = offsets[1] + sizeof(vec4) * capacity;
+  offsets[3] = offsets[2] + sizeof(vec4) * capacity;
+  offsets[4] = offsets[3] + sizeof(int) * capacity;
+  offsets[5] = offsets[4] + sizeof(int) * capacity;
+}
+
+// Set up the default quad & per instance attributes for the bound vertex array
+// NOTE: see resources/shaders/static.vert for the attribute locations
+static void r_instance_attribs(r_ctx* ctx, uint32_t buffer, uint32_t capacity,
+                               GLenum usage) {
+  size_t offsets[6];
+  r_instance_offsets(offsets, capacity);
+
+  glBindBuffer(GL_ARRAY_BUFFER, ctx->default_quad.vbo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ctx->default_quad.vboi);
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 20, (const void*)0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 20, (const void*)12);
+
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glBufferData(GL_ARRAY_BUFFER, offsets[5], 0, usage);
+
+  for (uint32_t i = 0; i < 4; ++i) {
+    glEnableVertexAttribArray(2 + i);
+    glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(mat4x4),
+                          (const void*)(offsets[0] + sizeof(vec4) * i));
+    glVertexAttribDivisor(2 + i, 1);
+  }
+
+  glEnableVertexAttribArray(6);
+  glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(vec4),
+                        (const void*)offsets[1]);
+  glVertexAttribDivisor(6, 1);
+
+  glEnableVertexAttribArray(7);
+  glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(vec4),
+                        (const void*)offsets[2]);
+  glVertexAttribDivisor(7, 1);
+
+  glEnableVertexAttribArray(8);
+  glVertexAttribIPointer(8, 1, GL_INT, sizeof(int), (const void*)offsets[3]);
+  glVertexAttribDivisor(8, 1);
+
+  glEnableVertexAttribArray(9);
+  glVertexAttribIPointer(9, 1, GL_INT, sizeof(int), (const void*)offsets[4]);
+  glVertexAttribDivisor(9, 1);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Upload a range of a batch's arrays into an instance buffer (bound to
+// GL_ARRAY_BUFFER) starting at instance `base`
+static void r_instance_upload(r_batch* batch, uint32_t capacity, uint32_t base,
+                              uint32_t start, uint32_t count) {
+  size_t offsets[6];
+  r_instance_offsets(offsets, capacity);
+
+  glBufferSubData(GL_ARRAY_BUFFER, offsets[0] + sizeof(mat4x4) * base,
+                  sizeof(mat4x4) * count, &batch->mats[start]);
+  glBufferSubData(GL_ARRAY_BUFFER, offsets[1] + sizeof(vec4) * base,
+                  sizeof(vec4) * count, &batch->coords[start]);
+  glBufferSubData(GL_ARRAY_BUFFER, offsets[2] + sizeof(vec4) * base,
+                  sizeof(vec4) * count, &batch->colors[start]);
+  glBufferSubData(GL_ARRAY_BUFFER, offsets[3] + sizeof(int) * base,
+                  sizeof(int) * count, &batch->flip_x[start]);
+  glBufferSubData(GL_ARRAY_BUFFER, offsets[4] + sizeof(int) * base,
+                  sizeof(int) * count, &batch->flip_y[start]);
+}
+
+static void r_indirect_check(r_ctx* ctx) {
+  r_indirect* indirect = &ctx->indirect;
+
+  indirect->supported = 0;
+
+  if (!glfwExtensionSupported("GL_ARB_multi_draw_indirect") ||
+      !glfwExtensionSupported("GL_ARB_base_instance")) {
+    return;
+  }
+
+  _r_multi_draw_elements_indirect = (r_multi_draw_indirect_proc)
+      glfwGetProcAddress("glMultiDrawElementsIndirect");
+
+  if (_r_multi_draw_elements_indirect) {
+    indirect->supported = 1;
+  }
+}
+
+static uint8_t r_indirect_create(r_ctx* ctx) {
+  r_indirect* indirect = &ctx->indirect;
+
+  if (indirect->vao) {
+    return 1;
+  }
+
+  uint32_t capacity = ctx->batch_capacity * ctx->batch_size;
+  if (!capacity) {
+    ASTERA_FUNC_DBG("no batches to submit indirectly.\n");
+    return 0;
+  }
+
+  glGenVertexArrays(1, &indirect->vao);
+  glGenBuffers(1, &indirect->instance_buffer);
+  glGenBuffers(1, &indirect->command_buffer);
+
+  glBindVertexArray(indirect->vao);
+  r_instance_attribs(ctx, indirect->instance_buffer, capacity, GL_STREAM_DRAW);
+  glBindVertexArray(0);
+
+  indirect->instance_capacity = capacity;
+
+  return 1;
+}
+
+static void r_indirect_destroy(r_indirect* indirect) {
+  if (indirect->vao) {
+    glDeleteVertexArrays(1, &indirect->vao);
+    glDeleteBuffers(1, &indirect->instance_buffer);
+    glDeleteBuffers(1, &indirect->command_buffer);
+  }
+
+  indirect->vao             = 0;
+  indirect->instance_buffer = 0;
+  indirect->command_buffer  = 0;
+}
+
+// Submit the batches in `batches` with one upload & command buffer, one
+// glMultiDrawElementsIndirect per run of batches that share a sheet
+// NOTE: the batches are expected to be ordered by sheet
+static void r_indirect_submit(r_ctx* ctx, r_batch** batches, uint32_t count) {
+  r_indirect* indirect = &ctx->indirect;
+  uint32_t    capacity = indirect->instance_capacity;
+
+  r_draw_cmd cmds[ASTERA_RENDER_INDIRECT_SHEETS];
+
+  glBindBuffer(GL_ARRAY_BUFFER, indirect->instance_buffer);
+
+  uint32_t base = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    r_batch* batch = batches[i];
+
+    cmds[i] = (r_draw_cmd){.count          = 6,
+                           .instance_count = batch->count,
+                           .first_index    = 0,
+                           .base_vertex    = 0,
+                           .base_instance  = base};
+
+    r_instance_upload(batch, capacity, base, 0, batch->count);
+
+    base += batch->count;
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  r_shader_bind(indirect->shader);
+  r_set_m4(indirect->shader, "view", ctx->camera.view);
+  r_set_m4(indirect->shader, "projection", ctx->camera.projection);
+
+  glBindVertexArray(indirect->vao);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect->command_buffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(r_draw_cmd) * count, cmds,
+               GL_STREAM_DRAW);
+
+  // A sampler index has to be the same across a draw's invocations, which
+  // gl_DrawIDARB isn't, so each sheet gets its own multi draw
+  uint32_t start = 0;
+  while (start < count) {
+    uint32_t run = 1;
+    while (start + run < count &&
+           batches[start + run]->sheet->id == batches[start]->sheet->id) {
+      ++run;
+    }
+
+    r_tex_bind(batches[start]->sheet->id);
+    _r_multi_draw_elements_indirect(GL_TRIANGLES, GL_UNSIGNED_SHORT,
+                                    (const void*)(sizeof(r_draw_cmd) * start),
+                                    run, 0);
+
+    start += run;
+  }
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    r_batch_clear(batches[i]);
+  }
+
+  r_tex_bind(0);
+  r_shader_bind(0);
+}
+
+static void r_batch_draw_indirect(r_ctx* ctx, uint8_t opaque) {
+  r_batch* batches[ASTERA_RENDER_INDIRECT_SHEETS];
+  uint32_t count = 0;
+
+  for (uint32_t i = 0; i < ctx->batch_capacity; ++i) {
+    r_batch* batch = &ctx->batches[i];
+
+    if (batch->count == 0 || !batch->sheet ||
+        batch->shader != ctx->indirect.shader || batch->opaque != opaque) {
+      continue;
+    }
+
+    r_batch_sort(batch, opaque);
+
+    // Keep batches of the same sheet next to each other for the submit
+    uint32_t j = count;
+    while (j > 0 && batches[j - 1]->sheet->id > batch->sheet->id) {
+      batches[j] = batches[j - 1];
+      --j;
+    }
+
+    batches[j] = batch;
+    ++count;
+
+    if (count == ASTERA_RENDER_INDIRECT_SHEETS) {
+      r_indirect_submit(ctx, batches, count);
+      count = 0;
+    }
+  }
+
+  if (count) {
+    r_indirect_submit(ctx, batches, count);
+  }
+}
+
 uint32_t r_check_error(void) { return glGetError(); }
 
 uint32_t r_check_error_loc(const char* loc) {
@@ -434,6 +760,8 @@ r_ctx* r_ctx_create(r_window_params params, uint8_t batch_count,
 
   ctx->default_quad = r_quad_create(1.f, 1.f, 0);
 
+  r_indirect_check(ctx);
+
   vec3 camera_position = {0.f, 0.f, 0.f};
   vec2 camera_size     = {(float)params.width, (float)params.height};
   ctx->camera = r_camera_create(camera_position, camera_size, -100.f, 100.f);
@@ -491,11 +819,15 @@ void r_ctx_destroy(r_ctx* ctx) {
 
       if (ctx->batches[i].flip_y)
         free(ctx->batches[i].flip_y);
+
+      free(ctx->batches[i].sort_keys);
+      free(ctx->batches[i].sort_scratch);
     }
 
     free(ctx->batches);
   }
 
+  r_indirect_destroy(&ctx->indirect);
   r_quad_destroy(&ctx->default_quad);
 
   r_window_destroy(ctx);
@@ -506,16 +838,57 @@ void r_ctx_destroy(r_ctx* ctx) {
 
 void r_ctx_update(r_ctx* ctx) { r_camera_update(&ctx->camera); }
 
-void r_ctx_draw(r_ctx* ctx) {
+// Draw every batch of one pass (opaque or translucent)
+static void r_ctx_draw_pass(r_ctx* ctx, uint8_t opaque) {
+  if (ctx->indirect.shader) {
+    r_batch_draw_indirect(ctx, opaque);
+  }
+
   for (uint32_t i = 0; i < ctx->batch_capacity; ++i) {
     r_batch* batch = &ctx->batches[i];
 
-    if (batch->count != 0) {
+    if (batch->count != 0 && batch->opaque == opaque) {
+      r_batch_sort(batch, opaque);
       r_batch_draw(ctx, batch);
     }
   }
 }
 
+void r_ctx_draw(r_ctx* ctx) {
+  // Opaque sprites go front to back without blending so the depth test
+  // rejects whatever they cover before it's shaded
+  glDisable(GL_BLEND);
+  r_ctx_draw_pass(ctx, 1);
+  glEnable(GL_BLEND);
+
+  // Translucent sprites go back to front on top, still writing depth so
+  // ordering between batches stays the same as before
+  r_ctx_draw_pass(ctx, 0);
+}
+
+uint8_t r_ctx_indirect_supported(r_ctx* ctx) {
+  return ctx->indirect.supported;
+}
+
+uint8_t r_ctx_set_indirect(r_ctx* ctx, r_shader shader) {
+  if (!shader) {
+    ctx->indirect.shader = 0;
+    return 1;
+  }
+
+  if (!ctx->indirect.supported) {
+    ASTERA_FUNC_DBG("multi draw indirect not supported.\n");
+    return 0;
+  }
+
+  if (!r_indirect_create(ctx)) {
+    return 0;
+  }
+
+  ctx->indirect.shader = shader;
+  return 1;
+}
+
 r_camera r_camera_create(vec3 position, vec2 size, float near, float far) {
   r_camera cam = (r_camera){.near = near, .far = far, .rotation = 0.f};
 
@@ -786,6 +1159,28 @@ r_sheet r_sheet_create(unsigned char* data, uint32_t length, vec4* sub_sprites,
   return (r_sheet){0};
 }
 
+// Check a sub texture's pixels for partial transparency
+static uint8_t r_subtex_scan_opaque(unsigned char* img, int32_t w, int32_t ch,
+                                    r_subtex* subtex) {
+  if (ch != 4) {
+    return 1;
+  }
+
+  for (uint32_t y = subtex->y; y < subtex->y + subtex->height; ++y) {
+    unsigned char* row = img + ((y * w) + subtex->x) * ch;
+
+    for (uint32_t x = 0; x < subtex->width; ++x) {
+      unsigned char alpha = row[(x * ch) + 3];
+
+      if (alpha != 0 && alpha != 255) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
 r_sheet r_sheet_create_tiled(unsigned char* data, uint32_t length,
                              uint32_t sub_width, uint32_t sub_height,
                              uint32_t width_pad, uint32_t height_pad) {
@@ -815,8 +1210,6 @@ r_sheet r_sheet_create_tiled(unsigned char* data, uint32_t length,
 
   glBindTexture(GL_TEXTURE_2D, 0);
 
-  stbi_image_free(img);
-
   uint32_t per_width = w / sub_width;
   uint32_t rows      = h / sub_height;
   uint32_t sub_count = rows * per_width;
@@ -847,8 +1240,12 @@ r_sheet r_sheet_create_tiled(unsigned char* data, uint32_t length,
                             .height = (uint32_t)height};
     vec2_dup(subtexs[i].o_offset, o_offset);
     vec4_dup(subtexs[i].coords, coords);
+
+    subtexs[i].opaque = r_subtex_scan_opaque(img, w, ch, &subtexs[i]);
   }
 
+  stbi_image_free(img);
+
   return (r_sheet){.id       = id,
                    .width    = (uint32_t)w,
                    .height   = (uint32_t)h,
@@ -1434,10 +1831,7 @@ void r_sprite_draw(r_ctx* ctx, r_sprite* sprite) {
 
   if (sprite->animated) {
     r_set_v4(sprite->shader, "coords",
-             sheet
-                 ->subtexs[sprite->render.anim.anim
-                               ->frames[sprite->render.anim.curr]]
-                 .coords);
+             sheet->subtexs[r_sprite_frame(sprite)].coords);
   } else {
     r_set_v4(sprite->shader, "coords",
              sheet->subtexs[sprite->render.tex].coords);
@@ -1462,20 +1856,26 @@ void r_sprite_draw(r_ctx* ctx, r_sprite* sprite) {
   r_shader_bind(0);
 }
 
-void r_sprite_draw_batch(r_ctx* ctx, r_sprite* sprite) {
+uint8_t r_sprite_draw_batch(r_ctx* ctx, r_sprite* sprite) {
   if (!sprite->visible) {
-    return;
+    return 0;
   }
 
-  r_batch* batch = r_batch_get(ctx, sprite->sheet, sprite->shader);
+  r_batch* batch =
+      r_batch_get(ctx, sprite->sheet, sprite->shader, r_sprite_opaque(sprite));
 
-  if (batch) {
-    if (batch->count == batch->capacity) {
-      r_batch_draw(ctx, batch);
-    }
+  if (!batch) {
+    ASTERA_FUNC_DBG("No batch found\n");
+    return 0;
+  }
 
-    r_batch_add(batch, sprite);
+  if (batch->count == batch->capacity) {
+    r_batch_draw(ctx, batch);
   }
+
+  r_batch_add(batch, sprite);
+
+  return 1;
 }
 
 uint32_t r_sprites_draw(r_ctx* ctx, r_sprite* sprites, uint32_t sprite_count) {
@@ -1484,31 +1884,440 @@ uint32_t r_sprites_draw(r_ctx* ctx, r_sprite* sprites, uint32_t sprite_count) {
     return 0;
   }
 
-  r_batch* batch = r_batch_get(ctx, sprites[0].sheet, sprites[0].shader);
+  // sprites[0] decides the sheet & shader, opacity is routed per sprite
+  r_batch* batches[2] = {0};
 
-  if (batch) {
-    uint32_t remaining = sprite_count, used = 0;
-    uint32_t index = 0;
-    while (1) {
-      uint32_t open = batch->capacity - batch->count;
-      used          = (open < remaining) ? open : remaining;
+  for (uint32_t i = 0; i < sprite_count; ++i) {
+    uint8_t   opaque = r_sprite_opaque(&sprites[i]);
+    r_batch** batch  = &batches[opaque];
 
-      uint32_t used_count = r_batch_add_multi(batch, &sprites[index], used);
+    if (!*batch) {
+      *batch = r_batch_get(ctx, sprites[0].sheet, sprites[0].shader, opaque);
 
-      index += used_count;
-      remaining -= used_count;
+      if (!*batch) {
+        ASTERA_FUNC_DBG("No batch found\n");
+        return i;
+      }
+    }
 
-      if (remaining && used)
-        r_batch_draw(ctx, batch);
-      else
-        break;
+    if ((*batch)->count == (*batch)->capacity) {
+      r_batch_draw(ctx, *batch);
     }
 
-    return index;
+    r_batch_add(*batch, &sprites[i]);
   }
 
-  ASTERA_FUNC_DBG("No batch found\n");
-  return 0;
+  return sprite_count;
+}
+
+// Grow a static batch's dirty range to include [start, end)
+static void r_static_batch_mark(r_static_batch* batch, uint32_t start,
+                                uint32_t end) {
+  if (batch->dirty_start == batch->dirty_end) {
+    batch->dirty_start = start;
+    batch->dirty_end   = end;
+    return;
+  }
+
+  if (start < batch->dirty_start)
+    batch->dirty_start = start;
+
+  if (end > batch->dirty_end)
+    batch->dirty_end = end;
+}
+
+// Decode the next codepoint of a UTF-8 string & advance it
+static uint32_t r_utf8_next(const char** str) {
+  const unsigned char* c = (const unsigned char*)*str;
+  uint32_t             codepoint;
+  uint8_t              length;
+
+  if (c[0] < 0x80) {
+    codepoint = c[0];
+    length    = 1;
+  } else if ((c[0] & 0xE0) == 0xC0 && c[1]) {
+    codepoint = ((c[0] & 0x1F) << 6) | (c[1] & 0x3F);
+    length    = 2;
+  } else if ((c[0] & 0xF0) == 0xE0 && c[1] && c[2]) {
+    codepoint = ((c[0] & 0x0F) << 12) | ((c[1] & 0x3F) << 6) | (c[2] & 0x3F);
+    length    = 3;
+  } else if ((c[0] & 0xF8) == 0xF0 && c[1] && c[2] && c[3]) {
+    codepoint = ((c[0] & 0x07) << 18) | ((c[1] & 0x3F) << 12) |
+                ((c[2] & 0x3F) << 6) | (c[3] & 0x3F);
+    length    = 4;
+  } else {
+    codepoint = '?';
+    length    = 1;
+  }
+
+  *str += length;
+  return codepoint;
+}
+
+r_font r_font_create(unsigned char* data, uint32_t length, float size,
+                     uint32_t first, uint32_t count) {
+  if (!data || !length || size <= 0.f || !count) {
+    ASTERA_FUNC_DBG("invalid font data passed.\n");
+    return (r_font){0};
+  }
+
+  stbtt_fontinfo info;
+  if (!stbtt_InitFont(&info, data, stbtt_GetFontOffsetForIndex(data, 0))) {
+    ASTERA_FUNC_DBG("unable to parse font.\n");
+    return (r_font){0};
+  }
+
+  float scale = stbtt_ScaleForPixelHeight(&info, size);
+  int   ascent, descent, line_gap;
+  stbtt_GetFontVMetrics(&info, &ascent, &descent, &line_gap);
+
+  r_font font = (r_font){.first    = first,
+                         .count    = count,
+                         .size     = size,
+                         .ascent   = ascent * scale,
+                         .descent  = descent * scale,
+                         .line_gap = line_gap * scale};
+
+  font.glyphs         = (r_glyph*)calloc(count, sizeof(r_glyph));
+  font.sheet.subtexs  = (r_subtex*)calloc(count, sizeof(r_subtex));
+  font.sheet.count    = count;
+  font.sheet.capacity = count;
+
+  unsigned char** sdfs = (unsigned char**)calloc(count, sizeof(unsigned char*));
+
+  // Generate every glyph & shelf pack them into rows of the atlas
+  const int      pad   = ASTERA_RENDER_FONT_SDF_PADDING;
+  const uint32_t width = ASTERA_RENDER_FONT_ATLAS_WIDTH;
+  uint32_t       x = 1, y = 1, row_height = 0;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    int advance, bearing, w = 0, h = 0, xoff = 0, yoff = 0;
+    stbtt_GetCodepointHMetrics(&info, first + i, &advance, &bearing);
+
+    sdfs[i] = stbtt_GetCodepointSDF(&info, scale, first + i, pad, 128,
+                                    128.f / pad, &w, &h, &xoff, &yoff);
+
+    font.glyphs[i] = (r_glyph){.subtex  = i,
+                               .advance = advance * scale,
+                               .x_off   = (float)xoff,
+                               .y_off   = (float)yoff};
+
+    if (sdfs[i] && (uint32_t)w + 2 > width) {
+      ASTERA_FUNC_DBG("glyph %u wider than the atlas.\n", first + i);
+      stbtt_FreeSDF(sdfs[i], 0);
+      sdfs[i] = 0;
+    }
+
+    if (!sdfs[i]) {
+      font.sheet.subtexs[i] = (r_subtex){.sub_id = i};
+      continue;
+    }
+
+    if (x + w + 1 > width) {
+      x = 1;
+      y += row_height + 1;
+      row_height = 0;
+    }
+
+    font.sheet.subtexs[i] = (r_subtex){.sub_id = i,
+                                       .x      = x,
+                                       .y      = y,
+                                       .width  = (uint32_t)w,
+                                       .height = (uint32_t)h};
+
+    x += w + 1;
+    if ((uint32_t)h > row_height) {
+      row_height = h;
+    }
+  }
+
+  uint32_t height = 1;
+  while (height < y + row_height + 1) {
+    height <<= 1;
+  }
+
+  unsigned char* atlas = (unsigned char*)calloc(width * height, 1);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    r_subtex* subtex = &font.sheet.subtexs[i];
+
+    if (sdfs[i]) {
+      for (uint32_t row = 0; row < subtex->height; ++row) {
+        memcpy(atlas + ((subtex->y + row) * width) + subtex->x,
+               sdfs[i] + (row * subtex->width), subtex->width);
+      }
+
+      stbtt_FreeSDF(sdfs[i], 0);
+    }
+
+    subtex->coords[0] = (float)subtex->x / width;
+    subtex->coords[1] = (float)subtex->y / height;
+    subtex->coords[2] = (float)(subtex->x + subtex->width) / width;
+    subtex->coords[3] = (float)(subtex->y + subtex->height) / height;
+  }
+
+  free(sdfs);
+
+  glGenTextures(1, &font.sheet.id);
+  glBindTexture(GL_TEXTURE_2D, font.sheet.id);
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  // Sample as white with the distance in alpha, so any batch shader works
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_ONE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_ONE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_ONE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_RED);
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED,
+               GL_UNSIGNED_BYTE, atlas);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  free(atlas);
+
+  font.sheet.width  = width;
+  font.sheet.height = height;
+
+  return font;
+}
+
+void r_font_destroy(r_font* font) {
+  r_sheet_destroy(&font->sheet);
+  free(font->glyphs);
+  *font = (r_font){0};
+}
+
+uint32_t r_text_draw(r_ctx* ctx, r_font* font, r_shader shader,
+                     const char* text, vec2 position, float size, vec4 color,
+                     uint8_t layer) {
+  if (!ctx || !font || !text) {
+    ASTERA_FUNC_DBG("incomplete arguments passed.\n");
+    return 0;
+  }
+
+  float scale       = size / font->size;
+  float line_height = (font->ascent - font->descent + font->line_gap) * scale;
+  vec2  pen         = {position[0], position[1]};
+
+  r_sprite glyph = (r_sprite){0};
+  glyph.shader   = shader;
+  glyph.sheet    = &font->sheet;
+  glyph.layer    = layer;
+  glyph.visible  = 1;
+  vec4_dup(glyph.color, color);
+
+  uint32_t drawn = 0;
+  while (*text) {
+    uint32_t codepoint = r_utf8_next(&text);
+
+    if (codepoint == '\n') {
+      pen[0] = position[0];
+      pen[1] += line_height;
+      continue;
+    }
+
+    if (codepoint < font->first || codepoint >= font->first + font->count) {
+      continue;
+    }
+
+    r_glyph*  info   = &font->glyphs[codepoint - font->first];
+    r_subtex* subtex = &font->sheet.subtexs[info->subtex];
+
+    if (subtex->width && subtex->height) {
+      float w = subtex->width * scale, h = subtex->height * scale;
+      float x = pen[0] + (info->x_off * scale) + (w * 0.5f);
+      float y = pen[1] + (info->y_off * scale) + (h * 0.5f);
+
+      glyph.render.tex = info->subtex;
+      mat4x4_translate(glyph.model, x, y, layer * ASTERA_RENDER_LAYER_MOD);
+      mat4x4_scale_aniso(glyph.model, glyph.model, w, h, 1.f);
+
+      if (r_sprite_draw_batch(ctx, &glyph)) {
+        ++drawn;
+      }
+    }
+
+    pen[0] += info->advance * scale;
+  }
+
+  return drawn;
+}
+
+float r_text_width(r_font* font, const char* text, float size) {
+  float scale = size / font->size;
+  float width = 0.f, line = 0.f;
+
+  while (*text) {
+    uint32_t codepoint = r_utf8_next(&text);
+
+    if (codepoint == '\n') {
+      line = 0.f;
+      continue;
+    }
+
+    if (codepoint >= font->first && codepoint < font->first + font->count) {
+      line += font->glyphs[codepoint - font->first].advance * scale;
+    }
+
+    if (line > width) {
+      width = line;
+    }
+  }
+
+  return width;
+}
+
+r_static_batch r_static_batch_create(r_ctx* ctx, r_sprite* sprites,
+                                     uint32_t count) {
+  if (!ctx || !sprites || !count) {
+    ASTERA_FUNC_DBG("incomplete arguments passed.\n");
+    return (r_static_batch){0};
+  }
+
+  // Every instance is drawn with the one sheet & shader
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!sprites[i].sheet || sprites[i].sheet->id != sprites[0].sheet->id ||
+        sprites[i].shader != sprites[0].shader) {
+      ASTERA_FUNC_DBG("sprite %i doesn't share sprite 0's sheet & shader.\n",
+                      i);
+      return (r_static_batch){0};
+    }
+  }
+
+  r_static_batch static_batch = (r_static_batch){0};
+  r_batch*       batch        = &static_batch.batch;
+
+  batch->shader   = sprites[0].shader;
+  batch->sheet    = sprites[0].sheet;
+  batch->capacity = count;
+  r_batch_check(batch);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    r_batch_add(batch, &sprites[i]);
+  }
+
+  glGenVertexArrays(1, &static_batch.vao);
+  glGenBuffers(1, &static_batch.buffer);
+
+  glBindVertexArray(static_batch.vao);
+  r_instance_attribs(ctx, static_batch.buffer, count, GL_DYNAMIC_DRAW);
+  glBindVertexArray(0);
+
+  r_static_batch_mark(&static_batch, 0, count);
+
+  return static_batch;
+}
+
+void r_static_batch_update(r_static_batch* batch, r_sprite* sprites,
+                           uint32_t start, uint32_t count) {
+  if (start + count > batch->batch.count) {
+    ASTERA_FUNC_DBG("range outside of batch.\n");
+    return;
+  }
+
+  for (uint32_t i = 0; i < count; ++i) {
+    r_batch_set(&batch->batch, start + i, &sprites[i]);
+  }
+
+  r_static_batch_mark(batch, start, start + count);
+}
+
+void r_static_batch_set_color(r_static_batch* batch, uint32_t index,
+                              vec4 color) {
+  if (index >= batch->batch.count)
+    return;
+
+  vec4_dup(batch->batch.colors[index], color);
+  r_static_batch_mark(batch, index, index + 1);
+}
+
+void r_static_batch_set_flip(r_static_batch* batch, uint32_t index,
+                             uint8_t flip_x, uint8_t flip_y) {
+  if (index >= batch->batch.count)
+    return;
+
+  batch->batch.flip_x[index] = flip_x;
+  batch->batch.flip_y[index] = flip_y;
+  r_static_batch_mark(batch, index, index + 1);
+}
+
+void r_static_batch_set_subtex(r_static_batch* batch, uint32_t index,
+                               uint32_t subtex) {
+  if (index >= batch->batch.count || subtex >= batch->batch.sheet->count)
+    return;
+
+  vec4_dup(batch->batch.coords[index],
+           batch->batch.sheet->subtexs[subtex].coords);
+  r_static_batch_mark(batch, index, index + 1);
+}
+
+void r_static_batch_draw(r_ctx* ctx, r_static_batch* batch) {
+  r_batch* data = &batch->batch;
+
+  if (!data->count) {
+    ASTERA_FUNC_DBG("nothing in batch to draw.\n");
+    return;
+  }
+
+  // Only the instances changed since the last draw get uploaded
+  if (batch->dirty_end > batch->dirty_start) {
+    glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+    r_instance_upload(data, data->capacity, batch->dirty_start,
+                      batch->dirty_start,
+                      batch->dirty_end - batch->dirty_start);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    batch->dirty_start = 0;
+    batch->dirty_end   = 0;
+  }
+
+  r_shader_bind(data->shader);
+  r_tex_bind(data->sheet->id);
+
+  r_set_m4(data->shader, "view", ctx->camera.view);
+  r_set_m4(data->shader, "projection", ctx->camera.projection);
+
+  glBindVertexArray(batch->vao);
+  glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0, data->count);
+  glBindVertexArray(0);
+
+  r_tex_bind(0);
+  r_shader_bind(0);
+}
+
+void r_static_batch_destroy(r_static_batch* batch) {
+  r_batch* data = &batch->batch;
+
+  if (data->mats)
+    free(data->mats);
+
+  if (data->coords)
+    free(data->coords);
+
+  if (data->colors)
+    free(data->colors);
+
+  if (data->flip_x)
+    free(data->flip_x);
+
+  if (data->flip_y)
+    free(data->flip_y);
+
+  free(data->sort_keys);
+  free(data->sort_scratch);
+
+  if (batch->vao) {
+    glDeleteVertexArrays(1, &batch->vao);
+    glDeleteBuffers(1, &batch->buffer);
+  }
+
+  *batch = (r_static_batch){0};
 }
 
 uint8_t r_sprite_get_anim_state(r_sprite* sprite) {
@@ -1516,6 +2325,10 @@ uint8_t r_sprite_get_anim_state(r_sprite* sprite) {
     return 0;
   }
 
+  if (sprite->render.anim.clock) {
+    return sprite->render.anim.clock->state;
+  }
+
   return sprite->render.anim.state;
 }
 
@@ -1873,6 +2686,118 @@ void r_anim_reset(r_anim_viewer* anim) {
   anim->curr   = 0;
 }
 
+// Get the index of the frame at a time, clamped to the animation's length
+static uint32_t r_anim_index_at(r_anim* anim, time_s time) {
+  if (anim->count == 0) {
+    return 0;
+  }
+
+  if (anim->rate > 0.f) {
+    uint32_t index = (uint32_t)(time / anim->rate);
+    return (index < anim->count) ? index : anim->count - 1;
+  }
+
+  time_s last = 0.f;
+  for (uint32_t i = 0; i < anim->count; ++i) {
+    last += anim->lengths[i];
+    if (time < last) {
+      return i;
+    }
+  }
+
+  return anim->count - 1;
+}
+
+static time_s r_anim_wrap(time_s time, time_s length) {
+#if defined(ASTERA_SYS_LOWP_TIME)
+  time = fmodf(time, length);
+#else
+  time = fmod(time, length);
+#endif
+
+  return (time < 0.f) ? time + length : time;
+}
+
+r_anim_clock r_anim_clock_create(r_anim* anim) {
+  if (!anim)
+    return (r_anim_clock){0};
+
+  if (!anim->count) {
+    ASTERA_FUNC_DBG("animation has no frames to step through.\n");
+    return (r_anim_clock){0};
+  }
+
+  time_s length = 0.f;
+  if (anim->rate > 0.f) {
+    length = anim->rate * anim->count;
+  } else if (anim->lengths) {
+    for (uint32_t i = 0; i < anim->count; ++i) {
+      length += anim->lengths[i];
+    }
+  }
+
+  return (r_anim_clock){.anim   = anim,
+                        .time   = 0.f,
+                        .length = length,
+                        .curr   = 0,
+                        .state  = R_ANIM_STOP,
+                        .pstate = R_ANIM_STOP,
+                        .loop   = anim->loop};
+}
+
+void r_anim_clock_update(r_anim_clock* clock, time_s delta) {
+  if (!clock->anim || clock->state != R_ANIM_PLAY) {
+    return;
+  }
+
+  clock->time += delta;
+
+  if (clock->time >= clock->length) {
+    if (clock->loop && clock->length > 0.f) {
+      clock->time = r_anim_wrap(clock->time, clock->length);
+    } else {
+      clock->time   = clock->length;
+      clock->pstate = R_ANIM_PLAY;
+      clock->state  = R_ANIM_STOP;
+    }
+  }
+
+  clock->curr = r_anim_index_at(clock->anim, clock->time);
+}
+
+uint32_t r_anim_clock_frame(r_anim_clock* clock, time_s phase) {
+  if (phase == 0.f) {
+    return clock->curr;
+  }
+
+  time_s time = clock->time + phase;
+
+  if (clock->loop && clock->length > 0.f) {
+    time = r_anim_wrap(time, clock->length);
+  } else if (time < 0.f) {
+    time = 0.f;
+  }
+
+  return r_anim_index_at(clock->anim, time);
+}
+
+void r_anim_clock_play(r_anim_clock* clock) {
+  clock->pstate = clock->state;
+  clock->state  = R_ANIM_PLAY;
+}
+
+void r_anim_clock_stop(r_anim_clock* clock) {
+  clock->pstate = clock->state;
+  clock->state  = R_ANIM_STOP;
+  clock->time   = 0.f;
+  clock->curr   = 0;
+}
+
+void r_anim_clock_pause(r_anim_clock* clock) {
+  clock->pstate = clock->state;
+  clock->state  = R_ANIM_PAUSE;
+}
+
 r_anim* r_anim_get(r_ctx* ctx, uint32_t id) {
   if (ctx->anim_count < id) {
     return 0;
@@ -2023,6 +2948,19 @@ void r_sprite_set_anim(r_sprite* sprite, r_anim* anim) {
   sprite->sheet       = anim->sheet;
 }
 
+void r_sprite_set_clock(r_sprite* sprite, r_anim_clock* clock, time_s phase) {
+  if (!clock->anim || !clock->anim->count) {
+    ASTERA_FUNC_DBG("clock has no animation frames to follow.\n");
+    return;
+  }
+
+  sprite->render.anim       = r_anim_create_viewer(clock->anim);
+  sprite->render.anim.clock = clock;
+  sprite->render.anim.phase = phase;
+  sprite->animated          = 1;
+  sprite->sheet             = clock->anim->sheet;
+}
+
 void r_sprite_set_tex(r_sprite* sprite, r_sheet* sheet, uint32_t id) {
   sprite->animated   = 0;
   sprite->render.tex = id;
@@ -2068,8 +3006,9 @@ r_sprite r_sprite_create(r_shader shader, vec2 pos, vec2 size) {
   return sprite;
 }
 
-void r_sprite_update(r_sprite* sprite, long delta) {
-  if (sprite->animated) {
+void r_sprite_update(r_sprite* sprite, time_s delta) {
+  // Clocked sprites are advanced once per clock in r_anim_clock_update
+  if (sprite->animated && !sprite->render.anim.clock) {
     r_anim_viewer* view = &sprite->render.anim;
 
     if (view->state == R_ANIM_PLAY) {
@@ -2080,7 +3019,9 @@ void r_sprite_update(r_sprite* sprite, long delta) {
         frame_time = view->anim->lengths[view->curr];
       }
 
-      if (view->time + delta >= frame_time) {
+      view->time += delta;
+
+      if (view->time >= frame_time) {
         if (view->curr >= view->count - 1) {
           if (!view->loop) {
             view->state  = R_ANIM_STOP;
@@ -2092,8 +3033,6 @@ void r_sprite_update(r_sprite* sprite, long delta) {
         }
 
         view->time -= frame_time;
-      } else {
-        view->time += delta;
       }
     }
   }
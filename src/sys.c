@@ -12,6 +12,10 @@
 #include <windows.h>
 #else
 #include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
 #include <stdlib.h>
@@ -78,11 +82,11 @@ static uint64_t s_get_ns() {
 /* Call the OS's sleep function for given milliseconds */
 time_s s_sleep(time_s duration) {
 #if defined(_WIN32) || defined(_WIN64)
-  Sleep(duration * MS_TO_MCS);
+  Sleep((DWORD)duration);
 #elif _POSIX_C_SOURCE >= 199309L
   struct timespec ts;
   ts.tv_sec  = duration / MS_TO_SEC;
-  ts.tv_nsec = fmod(duration, MS_TO_NS);
+  ts.tv_nsec = fmod(duration, MS_TO_SEC) * NS_TO_MS;
   nanosleep(&ts, NULL);
 #else
   uint32_t sleep_conv = duration / MS_TO_MCS;
@@ -105,6 +109,299 @@ time_s s_timer_update(s_timer* t) {
 /* Create the timer structure with current time */
 s_timer s_timer_create() { return (s_timer){s_get_time(), 0}; }
 
+struct s_thread_t {
+  s_thread_func func;
+  void*         data;
+  int32_t       result;
+#if defined(_WIN32) || defined(_WIN64)
+  HANDLE handle;
+#else
+  pthread_t handle;
+#endif
+};
+
+struct s_mutex_t {
+#if defined(_WIN32) || defined(_WIN64)
+  CRITICAL_SECTION section;
+#else
+  pthread_mutex_t mutex;
+#endif
+};
+
+/* Trampoline from the OS's thread signature to s_thread_func */
+#if defined(_WIN32) || defined(_WIN64)
+static DWORD WINAPI s_thread_entry(LPVOID data) {
+  s_thread thread = (s_thread)data;
+  thread->result  = thread->func(thread->data);
+  return 0;
+}
+#else
+static void* s_thread_entry(void* data) {
+  s_thread thread = (s_thread)data;
+  thread->result  = thread->func(thread->data);
+  return 0;
+}
+#endif
+
+s_thread s_thread_create(s_thread_func func, void* data) {
+  if (!func) {
+    ASTERA_FUNC_DBG("no function passed to run on thread.\n");
+    return 0;
+  }
+
+  s_thread thread = (s_thread)calloc(1, sizeof(struct s_thread_t));
+
+  if (!thread) {
+    ASTERA_FUNC_DBG("unable to allocate thread handle.\n");
+    return 0;
+  }
+
+  thread->func = func;
+  thread->data = data;
+
+#if defined(_WIN32) || defined(_WIN64)
+  thread->handle = CreateThread(0, 0, s_thread_entry, thread, 0, 0);
+  if (!thread->handle) {
+#else
+  if (pthread_create(&thread->handle, 0, s_thread_entry, thread) != 0) {
+#endif
+    ASTERA_FUNC_DBG("unable to start thread.\n");
+    free(thread);
+    return 0;
+  }
+
+  return thread;
+}
+
+int32_t s_thread_join(s_thread thread) {
+  if (!thread) {
+    return -1;
+  }
+
+#if defined(_WIN32) || defined(_WIN64)
+  WaitForSingleObject(thread->handle, INFINITE);
+  CloseHandle(thread->handle);
+#else
+  pthread_join(thread->handle, 0);
+#endif
+
+  int32_t result = thread->result;
+  free(thread);
+
+  return result;
+}
+
+s_mutex s_mutex_create() {
+  s_mutex mutex = (s_mutex)calloc(1, sizeof(struct s_mutex_t));
+
+  if (!mutex) {
+    ASTERA_FUNC_DBG("unable to allocate mutex.\n");
+    return 0;
+  }
+
+#if defined(_WIN32) || defined(_WIN64)
+  InitializeCriticalSection(&mutex->section);
+#else
+  if (pthread_mutex_init(&mutex->mutex, 0) != 0) {
+    ASTERA_FUNC_DBG("unable to initialize mutex.\n");
+    free(mutex);
+    return 0;
+  }
+#endif
+
+  return mutex;
+}
+
+void s_mutex_destroy(s_mutex mutex) {
+  if (!mutex)
+    return;
+
+#if defined(_WIN32) || defined(_WIN64)
+  DeleteCriticalSection(&mutex->section);
+#else
+  pthread_mutex_destroy(&mutex->mutex);
+#endif
+
+  free(mutex);
+}
+
+void s_mutex_lock(s_mutex mutex) {
+#if defined(_WIN32) || defined(_WIN64)
+  EnterCriticalSection(&mutex->section);
+#else
+  pthread_mutex_lock(&mutex->mutex);
+#endif
+}
+
+void s_mutex_unlock(s_mutex mutex) {
+#if defined(_WIN32) || defined(_WIN64)
+  LeaveCriticalSection(&mutex->section);
+#else
+  pthread_mutex_unlock(&mutex->mutex);
+#endif
+}
+
+struct s_map_t {
+  const unsigned char* data;
+  uint64_t             size;
+#if defined(_WIN32) || defined(_WIN64)
+  HANDLE file, mapping;
+#endif
+};
+
+s_map s_map_open(const char* path) {
+  if (!path) {
+    ASTERA_FUNC_DBG("no path passed to map.\n");
+    return 0;
+  }
+
+  s_map map = (s_map)calloc(1, sizeof(struct s_map_t));
+
+  if (!map) {
+    ASTERA_FUNC_DBG("unable to allocate map handle.\n");
+    return 0;
+  }
+
+#if defined(_WIN32) || defined(_WIN64)
+  LARGE_INTEGER size;
+
+  map->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+
+  if (map->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(map->file, &size) ||
+      !size.QuadPart) {
+    ASTERA_FUNC_DBG("unable to open %s to map.\n", path);
+    if (map->file != INVALID_HANDLE_VALUE) {
+      CloseHandle(map->file);
+    }
+    free(map);
+    return 0;
+  }
+
+  map->size    = (uint64_t)size.QuadPart;
+  map->mapping = CreateFileMappingA(map->file, 0, PAGE_READONLY, 0, 0, 0);
+
+  if (map->mapping) {
+    map->data = (const unsigned char*)MapViewOfFile(map->mapping,
+                                                    FILE_MAP_READ, 0, 0, 0);
+  }
+
+  if (!map->data) {
+    ASTERA_FUNC_DBG("unable to map %s.\n", path);
+    if (map->mapping) {
+      CloseHandle(map->mapping);
+    }
+    CloseHandle(map->file);
+    free(map);
+    return 0;
+  }
+#else
+  struct stat info;
+  int         fd = open(path, O_RDONLY);
+
+  if (fd < 0 || fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ASTERA_FUNC_DBG("unable to open %s to map.\n", path);
+    if (fd >= 0) {
+      close(fd);
+    }
+    free(map);
+    return 0;
+  }
+
+  void* data = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // The mapping keeps the file around on its own
+  close(fd);
+
+  if (data == MAP_FAILED) {
+    ASTERA_FUNC_DBG("unable to map %s.\n", path);
+    free(map);
+    return 0;
+  }
+
+  map->data = (const unsigned char*)data;
+  map->size = (uint64_t)info.st_size;
+#endif
+
+  return map;
+}
+
+void s_map_close(s_map map) {
+  if (!map)
+    return;
+
+#if defined(_WIN32) || defined(_WIN64)
+  UnmapViewOfFile((LPCVOID)map->data);
+  CloseHandle(map->mapping);
+  CloseHandle(map->file);
+#else
+  munmap((void*)map->data, (size_t)map->size);
+#endif
+
+  free(map);
+}
+
+const unsigned char* s_map_data(s_map map) { return map->data; }
+
+uint64_t s_map_size(s_map map) { return map->size; }
+
+void s_map_prefetch(s_map map, uint64_t offset, uint64_t length) {
+  if (offset >= map->size) {
+    return;
+  }
+
+  if (length > map->size - offset) {
+    length = map->size - offset;
+  }
+
+#if defined(_WIN32) || defined(_WIN64)
+  // PrefetchVirtualMemory needs Windows 8, pages fault in as they're read
+  (void)length;
+#else
+  // madvise wants a page aligned start
+  uint64_t page  = (uint64_t)sysconf(_SC_PAGESIZE);
+  uint64_t start = offset - (offset % page);
+
+  madvise((void*)(map->data + start), (size_t)(length + offset - start),
+          MADV_WILLNEED);
+#endif
+}
+
+uint32_t s_atomic_load(volatile uint32_t* ptr) {
+#if defined(_MSC_VER)
+  return (uint32_t)InterlockedCompareExchange((volatile LONG*)ptr, 0, 0);
+#else
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+void s_atomic_store(volatile uint32_t* ptr, uint32_t value) {
+#if defined(_MSC_VER)
+  InterlockedExchange((volatile LONG*)ptr, (LONG)value);
+#else
+  __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+uint32_t s_atomic_add(volatile uint32_t* ptr, uint32_t value) {
+#if defined(_MSC_VER)
+  return (uint32_t)InterlockedExchangeAdd((volatile LONG*)ptr, (LONG)value);
+#else
+  return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL);
+#endif
+}
+
+uint8_t s_atomic_cas(volatile uint32_t* ptr, uint32_t expected,
+                     uint32_t desired) {
+#if defined(_MSC_VER)
+  return (uint32_t)InterlockedCompareExchange(
+             (volatile LONG*)ptr, (LONG)desired, (LONG)expected) == expected;
+#else
+  return __atomic_compare_exchange_n(ptr, &expected, desired, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
 /* String reversal */
 static char* s_reverse(char* string, uint32_t length) {
   uint32_t start = 0;